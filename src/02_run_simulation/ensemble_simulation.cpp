@@ -0,0 +1,205 @@
+/**
+ * @file ensemble_simulation.cpp
+ *
+ * \brief Simulates an ensemble of variants of the hopping mechanism (build in
+ * 01) in parallel.
+ *
+ * Each variant (a row of the variant table) defines the excitation of the
+ * vastus muscle and optionally changes model parameters. The variants are
+ * simulated on a pool of worker threads and the results are merged into a
+ * single table indexed by the row of the variant. A failed run is reported and
+ * does not abort the remaining runs.
+ *
+ * The variant table is a whitespace separated text file with a header. The
+ * recognized columns are:
+ *
+ * - t0, t1, ..., x0, x1, ...: the times and values of the piecewise constant
+ *   excitation of the vastus
+ * - max_isometric_force: of the vastus (N)
+ * - stiffness: of the foot-floor contact (N/m)
+ * - <body>_mass: of the body (e.g., pelvis_mass) (kg)
+ *
+ * A NaN keeps the value of the model.
+ *
+ * Usage: ensemble_02 [variant table] [number of threads]
+ *
+ * @author agent <agent@local>
+ */
+#include "ControlSwitchEvent.h"
+#include "EnsembleRunner.h"
+#include "OutputReducer.h"
+#include "RolloutContext.h"
+
+#include <OpenSim/OpenSim.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+// Used to pause the flow of the program.
+#define PAUSE                                                                  \
+    cout << endl << "press a key to continue ..." << endl;                     \
+    getchar();
+
+/** A variant of the hopping mechanism. */
+struct HopperVariant {
+    vector<double> times, excitations;
+    double maxIsometricForce = NaN;
+    double contactStiffness = NaN;
+    map<string, double> masses;
+};
+
+/** Reads the variant table. */
+vector<HopperVariant> readVariants(const string& fileName) {
+    ifstream file(fileName);
+    if (!file) throw Exception("cannot read " + fileName);
+    string line;
+    getline(file, line);
+    istringstream header(line);
+    vector<string> labels;
+    string label;
+    while (header >> label) labels.push_back(label);
+    vector<HopperVariant> variants;
+    int lineNumber = 1;
+    while (getline(file, line)) {
+        lineNumber++;
+        istringstream row(line);
+        vector<double> values;
+        string value;
+        while (row >> value) values.push_back(stod(value));
+        if (values.empty()) continue;
+        if (values.size() != labels.size()) {
+            throw Exception(fileName + ":" + to_string(lineNumber) + ": " +
+                            "expected " + to_string(labels.size()) +
+                            " values");
+        }
+        HopperVariant variant;
+        map<int, double> times, excitations;
+        for (int i = 0; i < (int) labels.size(); i++) {
+            const auto& name = labels[i];
+            const string suffix = "_mass";
+            if (name.size() > 1 && (name[0] == 't' || name[0] == 'x') &&
+                name.find_first_not_of("0123456789", 1) == string::npos) {
+                (name[0] == 't' ? times : excitations)[stoi(name.substr(1))] =
+                        values[i];
+            } else if (name == "max_isometric_force") {
+                variant.maxIsometricForce = values[i];
+            } else if (name == "stiffness") {
+                variant.contactStiffness = values[i];
+            } else if (name.size() > suffix.size() &&
+                       name.compare(name.size() - suffix.size(), suffix.size(),
+                                    suffix) == 0) {
+                variant.masses[name.substr(0, name.size() - suffix.size())] =
+                        values[i];
+            } else {
+                throw Exception(fileName + ": unknown column " + name);
+            }
+        }
+        for (const auto& knot : times) {
+            if (!excitations.count(knot.first)) {
+                throw Exception(fileName + ": missing column x" +
+                                to_string(knot.first));
+            }
+            variant.times.push_back(knot.second);
+            variant.excitations.push_back(excitations[knot.first]);
+        }
+        variants.push_back(variant);
+    }
+    return variants;
+}
+
+/** Simulates a variant and returns the maximum and final height of the center
+ * of mass, and the number of integration steps. */
+vector<double> simulateVariant(const Model& baseModel,
+                               const HopperVariant& variant, double endTime) {
+    // Copying the model is not guaranteed to be thread-safe.
+    static mutex copyMutex;
+    unique_ptr<Model> model;
+    {
+        lock_guard<mutex> lock(copyMutex);
+        model.reset(baseModel.clone());
+    }
+
+    // Apply the model parameters of the variant.
+    if (!isNaN(variant.maxIsometricForce)) {
+        model->updMuscles().get("vastus").setMaxIsometricForce(
+                variant.maxIsometricForce);
+    }
+    if (!isNaN(variant.contactStiffness)) {
+        auto& contact = dynamic_cast<HuntCrossleyForce&>(
+                model->updForceSet().get("foot_floor_force"));
+        contact.setStiffness(variant.contactStiffness);
+    }
+    for (const auto& mass : variant.masses) {
+        if (!isNaN(mass.second)) {
+            model->updBodySet().get(mass.first).setMass(mass.second);
+        }
+    }
+
+    // Excite the vastus muscle (see simulateModel in tutorial_solutions.cpp).
+    auto brain = new PrescribedController();
+    brain->setActuators(model->updActuators());
+    vector<double> t = variant.times, x = variant.excitations;
+    if (t.empty()) {
+        t = {0.0, 1.0, 1.5};
+        x = {0.1, 1.0, 0.1};
+    }
+    auto controlFunction =
+            new PiecewiseConstantFunction((int) t.size(), &t[0], &x[0]);
+    brain->prescribeControlForActuator("vastus", controlFunction);
+    brain->setName("brain");
+    model->addController(brain);
+
+    auto maxHeight = new OutputReducer("", "com_position", "max", 1);
+    model->addAnalysis(maxHeight);
+    auto finalHeight = new OutputReducer("", "com_position", "final", 1);
+    model->addAnalysis(finalHeight);
+
+    // The integration stops at the switches of the excitation.
+    model->buildSystem();
+    ControlSwitchEvent::addToModel(*model);
+    auto& state = model->initializeState();
+    model->equilibrateMuscles(state);
+
+    RolloutContext context(*model);
+    context.setRecordStates(false);
+    context.simulate(state, endTime);
+    return {maxHeight->getValue(), finalHeight->getValue(),
+            (double) context.getNumStepsTaken()};
+}
+
+void simulateEnsemble(const string& variantFile, int numThreads) {
+    const double endTime = 5;
+    auto variants = readVariants(variantFile);
+    Model baseModel("Dennis.osim");
+
+    EnsembleRunner runner({"max_com_height", "final_com_height", "num_steps"},
+                          numThreads);
+    runner.run((int) variants.size(), [&](int i) {
+        return simulateVariant(baseModel, variants[i], endTime);
+    });
+
+    runner.printResults(baseModel.getName() + "_Ensemble.txt");
+    cout << "simulated " << variants.size() << " variants in "
+         << runner.getTotalWallTime() << " s (sum over runs)" << endl;
+    runner.printFailureReport(cout);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        string variantFile = argc > 1 ? argv[1] : "Dennis_Variants.txt";
+        int numThreads = argc > 2 ? atoi(argv[2]) : 0;
+        simulateEnsemble(variantFile, numThreads);
+    } catch (exception& e) {
+        cout << typeid(e).name() << ": " << e.what() << endl;
+        PAUSE;
+        return -1;
+    }
+    PAUSE;
+    return 0;
+}
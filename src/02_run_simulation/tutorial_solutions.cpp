@@ -9,8 +9,17 @@
  *
  * @author Dimitar Stanev <jimstanev@gmail.com>
  */
+#include "AsyncVisualizer.h"
+#include "BinaryStorage.h"
+#include "ControlSwitchEvent.h"
+#include "IntegratorTuner.h"
+#include "ModelSnapshot.h"
+#include "RolloutContext.h"
+#include "StreamingStateRecorder.h"
+
 #include <OpenSim/OpenSim.h>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 using namespace OpenSim;
@@ -21,7 +30,45 @@ using namespace SimTK;
     cout << endl << "press a key to continue ..." << endl;                     \
     getchar();
 
-void simulateModel() {
+/** Options of the simulation, set from the command line. */
+struct SimulationOptions {
+    /** Write the results in binary format (.osb, see BinaryStorage) instead
+     * of text, which is faster to write and read for long simulations; the
+     * files are converted to text with ConvertStorage (--binary). */
+    bool binaryOutput = false;
+    /** Stream the states to the file during the simulation instead of
+     * keeping them in memory (--stream). */
+    bool streamStates = false;
+    /** Sample the states and analyses at a fixed rate (Hz) instead of at
+     * every integration step (--rate <Hz>). */
+    double reportRate = 0;
+    /** Stop the integrator at the report times instead of interpolating
+     * (--stop). */
+    RolloutContext::ReportMode reportMode = RolloutContext::Interpolate;
+    /** Record only these state variables when reporting at a fixed rate
+     * (--states name,name,...). */
+    vector<string> recordedStates;
+    /** Visualize on the simulation thread, on a render thread
+     * (--async-visualizer) or not at all (--headless). */
+    VisualizationMode visualization = VisualizationMode::Inline;
+    /** Integrator settings that are loaded from a file, e.g., as selected
+     * by the tuning mode (--integrator file.xml). */
+    string integratorSettings;
+    /** Instead of simulating, select the fastest integrator settings that
+     * reproduce a reference simulation of 1 s within this error and save
+     * them to Dennis_IntegratorSettings.xml (--tune <tolerance>). */
+    double tuneTolerance = 0;
+    /** Restore the equilibrated initial state from Dennis.oss instead of
+     * equilibrating the muscles, or create the file if it is missing or
+     * outdated (--snapshot). */
+    bool useSnapshot = false;
+    /** Stop the integration at the switching times of the excitation
+     * instead of letting the integrator locate them by rejecting steps
+     * (disabled by --no-switching-events). */
+    bool switchingEvents = true;
+};
+
+void simulateModel(const SimulationOptions& options) {
     // Load the model
     Model model("Dennis.osim");
 
@@ -52,29 +99,136 @@ void simulateModel() {
     //*/
 #pragma endregion
 
+    // The states are written during the simulation with bounded memory.
+    string extension = options.binaryOutput ? ".osb" : ".sto";
+    if (options.streamStates) {
+        model.addAnalysis(new StreamingStateRecorder(model.getName() +
+                                                     "_States" + extension));
+    }
+
     // Build and initialize model.
-    model.setUseVisualizer(true);
-    auto& state = model.initSystem();
+    unique_ptr<AsyncVisualizer> asyncVisualizer;
+    if (options.visualization == VisualizationMode::Async) {
+        asyncVisualizer.reset(new AsyncVisualizer(model));
+    }
+    model.setUseVisualizer(options.visualization == VisualizationMode::Inline);
+    model.buildSystem();
+    if (options.switchingEvents) ControlSwitchEvent::addToModel(model);
+    auto& state = model.initializeState();
     model.updMatterSubsystem().setShowDefaultGeometry(true);
-    model.updVisualizer().updSimbodyVisualizer().setBackgroundColor(Vec3(1));
-    model.updVisualizer().updSimbodyVisualizer().drawFrameNow(state);
-    model.equilibrateMuscles(state);
+    if (options.visualization == VisualizationMode::Inline) {
+        auto& viz = model.updVisualizer().updSimbodyVisualizer();
+        viz.setBackgroundColor(Vec3(1));
+        viz.drawFrameNow(state);
+    } else if (asyncVisualizer) {
+        asyncVisualizer->start(state, [](SimTK::Visualizer& viz) {
+            viz.setBackgroundColor(Vec3(1));
+        });
+    }
+    if (options.useSnapshot) {
+        ModelSnapshot::equilibrateMuscles(model, state, "Dennis.osim",
+                                          model.getName() + ".oss");
+    } else {
+        model.equilibrateMuscles(state);
+    }
+
+    if (options.tuneTolerance > 0) {
+        IntegratorTuner tuner(model, state, 1.0);
+        auto settings = tuner.tune(options.tuneTolerance);
+        tuner.printReport(cout);
+        cout << "selected " << settings.get_integrator_method()
+             << " with accuracy " << settings.get_accuracy() << endl;
+        settings.print(model.getName() + "_IntegratorSettings.xml");
+        return;
+    }
+    unique_ptr<IntegratorSettings> integratorSettings;
+    if (!options.integratorSettings.empty()) {
+        integratorSettings.reset(
+                new IntegratorSettings(options.integratorSettings));
+    }
 
-    // Create the manager for the numerical integration.
-    Manager manager(model);
-    manager.initialize(state);
-    manager.integrate(5);
+    // Create the manager for the numerical integration or, when reporting
+    // at a fixed rate, a rollout context.
+    unique_ptr<Manager> manager;
+    unique_ptr<RolloutContext> context;
+    const Storage* states = nullptr;
+    if (options.reportRate > 0) {
+        context.reset(new RolloutContext(model));
+        if (integratorSettings) integratorSettings->applyTo(*context);
+        context->setReportInterval(1 / options.reportRate, options.reportMode);
+        context->setRecordedStates(options.recordedStates);
+        context->setRecordStates(!options.streamStates);
+        context->simulate(state, 5);
+        if (!options.streamStates) states = &context->getStateStorage();
+    } else {
+        manager.reset(new Manager(model));
+        if (integratorSettings) integratorSettings->applyTo(*manager);
+        manager->setWriteToStorage(!options.streamStates);
+        manager->initialize(state);
+        manager->integrate(5);
+        if (!options.streamStates) states = &manager->getStateStorage();
+    }
+    if (asyncVisualizer) asyncVisualizer->stop();
 
     // Save simulation results.
-    model.printControlStorage(model.getName() + "_Controls.sto");
-    manager.getStateStorage().print(model.getName() + "_States.sto");
-    forceReporter->printResults(model.getName());
-    bodyKinematics->printResults(model.getName());
+    if (!options.binaryOutput) {
+        model.printControlStorage(model.getName() + "_Controls.sto");
+        if (states) states->print(model.getName() + "_States.sto");
+        forceReporter->printResults(model.getName());
+        bodyKinematics->printResults(model.getName());
+    } else {
+        BinaryStorage::write(model.getControlsTable(), "controls",
+                             model.getName() + "_Controls.osb");
+        if (states) {
+            BinaryStorage::write(*states, model.getName() + "_States.osb");
+        }
+        BinaryStorage::write(forceReporter->getForceStorage(),
+                             model.getName() + "_ForceReporter_forces.osb");
+        BinaryStorage::write(*bodyKinematics->getPositionStorage(),
+                             model.getName() + "_BodyKinematics_pos.osb");
+        BinaryStorage::write(*bodyKinematics->getVelocityStorage(),
+                             model.getName() + "_BodyKinematics_vel.osb");
+        BinaryStorage::write(*bodyKinematics->getAccelerationStorage(),
+                             model.getName() + "_BodyKinematics_acc.osb");
+    }
 }
 
 int main(int argc, char* argv[]) {
     try {
-        simulateModel();
+        SimulationOptions options;
+        for (int i = 1; i < argc; i++) {
+            string argument = argv[i];
+            if (argument == "--binary") {
+                options.binaryOutput = true;
+            } else if (argument == "--stream") {
+                options.streamStates = true;
+            } else if (argument == "--rate" && i + 1 < argc) {
+                options.reportRate = stod(argv[++i]);
+            } else if (argument == "--async-visualizer") {
+                options.visualization = VisualizationMode::Async;
+            } else if (argument == "--headless") {
+                options.visualization = VisualizationMode::Headless;
+            } else if (argument == "--integrator" && i + 1 < argc) {
+                options.integratorSettings = argv[++i];
+            } else if (argument == "--tune" && i + 1 < argc) {
+                options.tuneTolerance = stod(argv[++i]);
+            } else if (argument == "--no-switching-events") {
+                options.switchingEvents = false;
+            } else if (argument == "--snapshot") {
+                options.useSnapshot = true;
+            } else if (argument == "--stop") {
+                options.reportMode = RolloutContext::Stop;
+            } else if (argument == "--states" && i + 1 < argc) {
+                istringstream names(argv[++i]);
+                string name;
+                while (getline(names, name, ',')) {
+                    options.recordedStates.push_back(name);
+                }
+            } else {
+                throw Exception("unknown argument " + argument);
+            }
+        }
+        simulateModel(options);
     } catch (exception& e) {
         cout << typeid(e).name() << ": " << e.what() << endl;
         PAUSE;
@@ -0,0 +1,113 @@
+/**
+ * @file BenchmarkHopperRollout.cpp
+ *
+ * \brief Measures the overhead of an evaluation of the hopper objective
+ * (setup of the simulation) apart from the integration time, when a Manager
+ * is constructed for each evaluation and when a RolloutContext is reused.
+ * Both methods perform the same work: the states are recorded, the jump
+ * height is reduced by an OutputReducer and no switching events are used.
+ *
+ * Usage: BenchmarkHopperRollout [number of evaluations]
+ *
+ * @author agent <agent@local>
+ */
+#include "HighJumpOptimization.h"
+
+#include <OpenSim/OpenSim.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+typedef chrono::steady_clock Clock;
+
+double elapsed(Clock::time_point start, Clock::time_point end) {
+    return chrono::duration<double>(end - start).count();
+}
+
+// Deterministic set of controls for evaluation k.
+Vector createControls(int N, int k) {
+    Vector controls(N);
+    for (int i = 0; i < N; i++) controls[i] = 0.1 + 0.8 * ((k * N + i) % 7) / 6;
+    return controls;
+}
+
+void report(const string& method, int numEvaluations, double setup,
+            double integration) {
+    cout << setw(16) << left << method << setw(16) << right
+         << 1000 * setup / numEvaluations << setw(16)
+         << 1000 * integration / numEvaluations << endl;
+}
+
+// The evaluation as performed by the tutorial: new control function and new
+// Manager for each evaluation.
+void benchmarkManager(const vector<double>& timePoints, double tf,
+                      int numEvaluations) {
+    Model model("Dennis.osim");
+    auto maxHeight = new OutputReducer("", "com_position", "max", 1);
+    model.addAnalysis(maxHeight);
+    auto controller = new PrescribedController();
+    controller->setActuators(model.updActuators());
+    controller->setName("brain");
+    model.addController(controller);
+    auto state = model.initSystem();
+    model.equilibrateMuscles(state);
+
+    int N = (int) timePoints.size();
+    double setup = 0, integration = 0;
+    for (int k = 0; k < numEvaluations; k++) {
+        auto controls = createControls(N, k);
+        auto start = Clock::now();
+        auto workingState = state;
+        auto controlFunction = new PiecewiseConstantFunction(
+                N, &timePoints[0], &controls[0]);
+        controller->prescribeControlForActuator("vastus", controlFunction);
+        Manager manager(model);
+        manager.initialize(workingState);
+        auto initialized = Clock::now();
+        manager.integrate(tf);
+        auto end = Clock::now();
+        setup += elapsed(start, initialized);
+        integration += elapsed(initialized, end);
+    }
+    report("Manager", numEvaluations, setup, integration);
+}
+
+// The evaluation of HighJumpOptimization with a reusable RolloutContext.
+void benchmarkRolloutContext(const vector<double>& timePoints, double tf,
+                             int numEvaluations) {
+    HopperSettings settings;
+    settings.useSwitchingEvents = false;
+    HopperRollout rollout(timePoints, tf, settings);
+
+    int N = (int) timePoints.size();
+    double setup = 0, integration = 0;
+    for (int k = 0; k < numEvaluations; k++) {
+        rollout.simulate(createControls(N, k));
+        setup += rollout.updContext().getSetupTime();
+        integration += rollout.updContext().getIntegrationTime();
+    }
+    report("RolloutContext", numEvaluations, setup, integration);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        int numEvaluations = argc > 1 ? atoi(argv[1]) : 20;
+        int N = 5;
+        double tf = 1.5;
+        vector<double> timePoints;
+        for (int i = 0; i < N; i++) timePoints.push_back(tf / N * i);
+
+        cout << setw(16) << left << "method" << setw(16) << right
+             << "setup (ms)" << setw(16) << "integration (ms)" << endl;
+        benchmarkManager(timePoints, tf, numEvaluations);
+        benchmarkRolloutContext(timePoints, tf, numEvaluations);
+    } catch (exception& e) {
+        cout << typeid(e).name() << ": " << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,517 @@
+#include "HighJumpOptimization.h"
+
+#include "ControlSwitchEvent.h"
+#include "ModelSnapshot.h"
+#include "ParallelTasks.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+namespace {
+// The control function of the parametrization (see
+// HopperSettings::controlBasis).
+OpenSim::Function* createControlFunction(const string& basis, int degree,
+                                         const vector<double>& timePoints,
+                                         double endTime,
+                                         const Vector& controls) {
+    if (basis.empty()) {
+        return new PiecewiseConstantFunction(
+                controls.size(), &timePoints[0], &controls[0]);
+    }
+    return new ControlBasisFunction(basis, degree, 0, endTime, controls);
+}
+} // namespace
+
+HopperRollout::HopperRollout(const vector<double>& timePoints, double endTime,
+                             const HopperSettings& settings,
+                             PrefixStateCache* prefixCache)
+        : prefixCache(settings.recordAnalyses ||
+                                      !settings.controlBasis.empty() ||
+                                      settings.numScenarios > 0
+                              ? nullptr
+                              : prefixCache),
+          timePoints(timePoints), endTime(endTime) {
+    // Setup model. The file is parsed once and copied for each worker.
+    model = ModelSnapshot::loadModel("Dennis.osim");
+
+    // Add force and body kinematics analyses in order to record the forces
+    // and body kinematics, respectively.
+    if (settings.recordAnalyses) {
+        forceReporter = new ForceReporter();
+        model.addAnalysis(forceReporter);
+        bodyKinematics = new BodyKinematics();
+        model.addAnalysis(bodyKinematics);
+    }
+
+    // The jump height is the maximum vertical position of the center of
+    // mass, which is reduced while the simulation advances.
+    maxHeight = new OutputReducer("", "com_position", "max", 1);
+    model.addAnalysis(maxHeight);
+
+    // Create a controller to excite the vastus muscle. The control function
+    // is kept and its values are updated in place by each rollout.
+    controller = new PrescribedController();
+    controller->setActuators(model.updActuators());
+    controller->setName("brain");
+    auto function = createControlFunction(
+            settings.controlBasis, settings.controlDegree, timePoints, endTime,
+            Vector((int) timePoints.size(), 0.01));
+    controlFunction = dynamic_cast<PiecewiseConstantFunction*>(function);
+    basisFunction = dynamic_cast<ControlBasisFunction*>(function);
+    controller->prescribeControlForActuator("vastus", function);
+    model.addController(controller);
+
+    // The perturbation of the scenarios, whose seed is selected by each
+    // simulation.
+    if (settings.numScenarios > 0) {
+        perturbation = new PerturbationForce();
+        perturbation->setName("perturbation");
+        perturbation->set_body_name(settings.perturbedBody);
+        perturbation->set_magnitude(settings.perturbationMagnitude);
+        model.addForce(perturbation);
+    }
+
+    // Build the system, so that the switching and termination events can be
+    // added before the initial state is created.
+    model.buildSystem();
+    if (settings.useSwitchingEvents) ControlSwitchEvent::addToModel(model);
+    // The bound of a scenario is not a bound of the mean over the scenarios
+    // and the bound of a flight is not a bound of the later hops.
+    bool terminateWhenDominated = settings.terminateWhenDominated &&
+                                  settings.terminateAtApex &&
+                                  settings.numScenarios == 0;
+    if (settings.terminateAtApex || terminateWhenDominated) {
+        auto airborne =
+                TerminationEvent::isAirborne(model, "foot_floor_force");
+        if (settings.terminateAtApex) {
+            TerminationEvent::addToModel(
+                    model, TerminationEvent::createApexEvent(model, airborne));
+        }
+        if (terminateWhenDominated) {
+            TerminationEvent::addToModel(
+                    model, TerminationEvent::createBallisticBoundEvent(
+                                   model, airborne, &incumbentHeight));
+        }
+    }
+
+    // Initialize model and equilibrate muscles.
+    state = model.initializeState();
+    if (settings.snapshotFile.empty()) {
+        model.equilibrateMuscles(state);
+    } else {
+        ModelSnapshot::equilibrateMuscles(model, state, "Dennis.osim",
+                                          settings.snapshotFile);
+    }
+
+    // The integrator and the state storage are reused by all rollouts.
+    context.reset(new RolloutContext(model));
+    if (settings.accuracy > 0) context->setAccuracy(settings.accuracy);
+    if (settings.useMultiFidelity) {
+        screeningContext.reset(new RolloutContext(model));
+        screeningContext->setRecordStates(false);
+        screeningContext->setAccuracy(settings.screeningAccuracy);
+        if (settings.screeningStepSize > 0) {
+            screeningContext->setFixedStepSize(settings.screeningStepSize);
+        }
+    }
+
+    // The integration is restarted at each knot, where the state is stored
+    // in the prefix cache. The state at knot k depends on the first k + 1
+    // controls, since the last stage of the integrator evaluates the
+    // derivatives at the knot, where control k is already active.
+    if (this->prefixCache) {
+        context->setRestartTimes(
+                vector<double>(timePoints.begin() + 1, timePoints.end()));
+        context->setRestartCallback([this](const State& s, int i) {
+            // Restart i is at knot i + 1. The state at the last knot depends
+            // on all the controls, thus, it is never resumed.
+            int length = i + 2;
+            if (length >= (int) currentControls.size()) return;
+            PrefixStateCache::Snapshot snapshot;
+            snapshot.time = s.getTime();
+            snapshot.y = s.getY();
+            snapshot.reducers.push_back(maxHeight->getAccumulator());
+            this->prefixCache->insert(currentControls, length, snapshot);
+        });
+    }
+}
+
+double HopperRollout::simulate(const Vector& newControls,
+                               FidelityStatistics::Fidelity fidelity,
+                               bool allowResume) {
+    // Initialization
+    if (forceReporter) forceReporter->updForceStorage().reset(0);
+    if (bodyKinematics) {
+        bodyKinematics->getPositionStorage()->reset(0);
+        bodyKinematics->getAccelerationStorage()->reset(0);
+        bodyKinematics->getVelocityStorage()->reset(0);
+    }
+
+    // Update controller from newControls.
+#pragma region task_5a
+    //*/
+    int N = newControls.size();
+    if (basisFunction) {
+        basisFunction->setCoefficients(newControls);
+    } else {
+        for (int i = 0; i < N; i++) controlFunction->setY(i, newControls[i]);
+    }
+    //*/
+#pragma endregion
+
+    // Perform the simulation starting from the equilibrated state. The
+    // rollout context replaces the Manager, so that the integrator is not
+    // constructed for each simulation.
+#pragma region task_5b
+    //*/
+    auto& activeContext =
+            fidelity == FidelityStatistics::High ? *context : *screeningContext;
+    PrefixStateCache::Snapshot snapshot;
+    int prefix = 0;
+    currentControls = newControls;
+    if (prefixCache && allowResume && fidelity == FidelityStatistics::High) {
+        prefix = prefixCache->lookup(newControls, N - 1, snapshot);
+    }
+    resumed = prefix > 0;
+    if (resumed) {
+        resumeState = state;
+        resumeState.setTime(snapshot.time);
+        resumeState.updY() = snapshot.y;
+        maxHeight->setAccumulator(snapshot.reducers[0]);
+        activeContext.simulate(resumeState, endTime, false);
+    } else {
+        activeContext.simulate(state, endTime);
+    }
+    wallTime = activeContext.getSetupTime() +
+               activeContext.getIntegrationTime();
+    //*/
+#pragma endregion
+
+    // Evaluate objective function, which is to maximize the jump height.
+#pragma region task_5c
+    //*/
+    return max(0.0, maxHeight->getValue());
+    //*/
+#pragma endregion
+}
+
+void HopperRollout::setScenario(int seed) {
+    if (!perturbation) {
+        throw Exception("HopperRollout: the settings have no scenarios");
+    }
+    perturbation->setSeed(seed);
+}
+
+const Storage& HopperRollout::getStateStorage() const {
+    return context->getStateStorage();
+}
+
+HighJumpOptimization::HighJumpOptimization(int numParameters, double endTime,
+                                           const HopperSettings& settings)
+        : OptimizerSystem(numParameters), endTime(endTime), stepCount(0),
+          checkpointFile(settings.checkpointFile),
+          checkpointInterval(max(settings.checkpointInterval, 1)),
+          recentSamples(max(settings.populationSize, 1)),
+          screeningMargin(settings.screeningMargin),
+          screeningAuditInterval(settings.screeningAuditInterval),
+          numRejected(0), controlBasis(settings.controlBasis),
+          controlDegree(settings.controlDegree),
+          numScenarios(max(settings.numScenarios, 0)),
+          scenarioSeed(settings.scenarioSeed),
+          terminateWhenDominated(settings.terminateWhenDominated &&
+                                 settings.terminateAtApex &&
+                                 settings.numScenarios == 0) {
+    // Partition the time uniformly based on the number of parameters and
+    // final time.
+    for (int i = 0; i < numParameters; i++) {
+        timePoints.push_back(endTime / numParameters * i);
+    }
+
+    if (settings.cacheTolerance > 0) {
+        // The signature identifies the study of the cache file.
+        ostringstream signature;
+        // The content hash invalidates the cache when the model is edited.
+        signature << "Dennis.osim hash="
+                  << ModelSnapshot::hashFile("Dennis.osim")
+                  << " N=" << numParameters
+                  << " endTime=" << endTime
+                  << " terminateAtApex=" << settings.terminateAtApex
+                  << " terminateWhenDominated="
+                  << settings.terminateWhenDominated
+                  << " accuracy=" << settings.accuracy
+                  << " useSwitchingEvents=" << settings.useSwitchingEvents
+                  << " useMultiFidelity=" << settings.useMultiFidelity;
+        if (settings.useMultiFidelity) {
+            signature << " screeningAccuracy=" << settings.screeningAccuracy
+                      << " screeningStepSize=" << settings.screeningStepSize
+                      << " screeningMargin=" << settings.screeningMargin;
+        }
+        if (!controlBasis.empty()) {
+            signature << " controlBasis=" << controlBasis
+                      << " controlDegree=" << controlDegree;
+        }
+        if (numScenarios > 0) {
+            signature << " numScenarios=" << numScenarios
+                      << " scenarioSeed=" << scenarioSeed
+                      << " perturbedBody=" << settings.perturbedBody
+                      << " perturbationMagnitude="
+                      << settings.perturbationMagnitude;
+        }
+        cache.reset(new EvaluationCache(settings.cacheTolerance,
+                                        settings.cacheCapacity,
+                                        settings.cacheFile, signature.str()));
+    }
+
+    gradientEngine.reset(new FiniteDifferenceGradient(
+            [this](const Vector& controls) {
+                // A truncated or screened simulation would bias the
+                // differences.
+                return -1 * evaluate(controls, true);
+            },
+            settings.gradientMethod, max(settings.numWorkers, 1)));
+    // The default steps are based on the accuracy of the simulations (1e-3
+    // is the default of the integrator).
+    gradientEngine->setFunctionAccuracy(
+            settings.accuracy > 0 ? settings.accuracy : 1e-3);
+    if (settings.gradientStepSizes.size() > 0) {
+        gradientEngine->setStepSizes(settings.gradientStepSizes);
+    }
+
+    // The results of the best solution are printed on a background thread,
+    // so that the optimization does not wait for the disk.
+    resultModel.reset(new Model("Dennis.osim"));
+    resultController = new PrescribedController();
+    resultController->setActuators(resultModel->updActuators());
+    resultController->setName("brain");
+    resultModel->addController(resultController);
+    writer.reset(new AsyncWriter());
+
+    if (settings.useMultiFidelity && numScenarios == 0) {
+        fidelityStatistics.reset(new FidelityStatistics());
+    }
+    if (settings.usePrefixCache) {
+        prefixCache.reset(new PrefixStateCache(settings.prefixCacheCapacity));
+    }
+    // Each worker owns an independent model instance.
+    for (int i = 0; i < max(settings.numWorkers, 1); i++) {
+        rollouts.add(unique_ptr<HopperRollout>(new HopperRollout(
+                timePoints, endTime, settings, prefixCache.get())));
+    }
+}
+
+int HighJumpOptimization::objectiveFunc(const Vector& newControls,
+                                        bool new_coefficients, Real& f) const {
+    // OptimizerSystem assumes that the objective function is minimized.
+    f = -1 * evaluate(newControls);
+    // Only the samples of the optimizer are recorded (not the finite
+    // difference points of gradientFunc).
+    recordEvaluation(newControls);
+    return 0;
+}
+
+int HighJumpOptimization::gradientFunc(const Vector& controls,
+                                       bool new_coefficients,
+                                       Vector& gradient) const {
+    double *lower = nullptr, *upper = nullptr;
+    if (getHasLimits()) getParameterLimits(&lower, &upper);
+    gradientEngine->setBounds(lower, upper);
+    gradientEngine->compute(controls, gradient);
+    return 0;
+}
+
+double HighJumpOptimization::getBestObjective() const {
+    lock_guard<mutex> lock(bestMutex);
+    return bestSolution;
+}
+
+Vector HighJumpOptimization::getBestControls() const {
+    lock_guard<mutex> lock(bestMutex);
+    return bestControls;
+}
+
+double HighJumpOptimization::evaluate(const Vector& controls,
+                                      bool exact) const {
+    // A cached evaluation is returned without simulation, unless it improves
+    // on the best solution (e.g., loaded from the cache file), because the
+    // results of the best solution are printed.
+    double height;
+    bool isCached = cache && !(exact && terminateWhenDominated) &&
+                    cache->lookup(controls, height);
+    if (isCached && -height < getBestObjective()) {
+        cache->countHitAsMiss();
+        isCached = false;
+    }
+    if (!isCached) {
+        if (numScenarios > 0) {
+            Storage states;
+            height = simulateScenarios(controls, states);
+            if (cache) cache->insert(controls, height);
+            updateBestSolution(controls, -1 * height, states);
+        } else {
+            auto rollout = rollouts.acquire();
+            double bestHeight = -getBestObjective();
+            rollout->setIncumbent(exact ? -Infinity : bestHeight);
+            bool isHighFidelity = true;
+            height = exact ? rollout->simulate(controls)
+                           : simulate(*rollout, controls, bestHeight,
+                                      isHighFidelity);
+            // The results of a new best solution are printed, thus, a
+            // resumed simulation is repeated from the initial state.
+            if (rollout->isResumed() && -height < getBestObjective()) {
+                height = rollout->simulate(controls, FidelityStatistics::High,
+                                           false);
+            }
+            // The estimated height of a rejected candidate is not cached,
+            // so that it is never returned as a full accuracy result.
+            if (cache && isHighFidelity) cache->insert(controls, height);
+            updateBestSolution(controls, -1 * height,
+                               rollout->getStateStorage());
+        }
+    }
+    return height;
+}
+
+double HighJumpOptimization::simulate(HopperRollout& rollout,
+                                      const Vector& controls,
+                                      double bestHeight,
+                                      bool& isHighFidelity) const {
+    isHighFidelity = true;
+    if (!fidelityStatistics) {
+        return rollout.simulate(controls, FidelityStatistics::High);
+    }
+
+    // Screen the candidate with a low-fidelity simulation.
+    double lowHeight = rollout.simulate(controls, FidelityStatistics::Low);
+    fidelityStatistics->recordEvaluation(FidelityStatistics::Low,
+                                         rollout.getWallTime());
+    bool rejected = lowHeight + screeningMargin < bestHeight;
+    if (rejected) {
+        fidelityStatistics->recordRejection();
+        bool audit = screeningAuditInterval > 0 &&
+                     ++numRejected % screeningAuditInterval == 0;
+        if (!audit) {
+            // The low-fidelity height corrected by the measured bias, but
+            // never above the threshold of the screening.
+            isHighFidelity = false;
+            double bias = fidelityStatistics->getBias();
+            if (isNaN(bias)) bias = 0;
+            return min(lowHeight - bias, bestHeight - screeningMargin);
+        }
+    }
+
+    double highHeight = rollout.simulate(controls, FidelityStatistics::High);
+    fidelityStatistics->recordEvaluation(FidelityStatistics::High,
+                                         rollout.getWallTime());
+    fidelityStatistics->recordPair(lowHeight, highHeight);
+    return highHeight;
+}
+
+double HighJumpOptimization::simulateScenarios(const Vector& controls,
+                                               Storage& states) const {
+    // The scenarios are the same for all candidates (common random numbers).
+    // Concurrent candidates (e.g., of a CMA-ES generation) share the rollouts
+    // of the pool.
+    vector<double> heights(numScenarios);
+    parallelFor(
+            numScenarios,
+            [&](int k) {
+                auto rollout = rollouts.acquire();
+                rollout->setScenario(scenarioSeed + k);
+                heights[k] =
+                        rollout->simulate(controls, FidelityStatistics::High);
+                if (k == 0) states = rollout->getStateStorage();
+            },
+            getNumWorkers());
+    // Summed in the order of the scenarios, so that the mean does not depend
+    // on the order in which the simulations finish.
+    double sum = 0;
+    for (double height : heights) sum += height;
+    return sum / numScenarios;
+}
+
+void HighJumpOptimization::recordEvaluation(const Vector& controls) const {
+    lock_guard<mutex> lock(bestMutex);
+    recentSamples[nextSample] = controls;
+    nextSample = (nextSample + 1) % recentSamples.size();
+    int count = ++stepCount;
+    if (checkpointFile.empty() || count % checkpointInterval != 0) return;
+
+    OptimizationCheckpoint checkpoint;
+    checkpoint.numEvaluations = count;
+    checkpoint.bestObjective = bestSolution;
+    checkpoint.incumbent = bestControls;
+    vector<Vector> samples;
+    for (const auto& sample : recentSamples) {
+        if (sample.size() > 0) samples.push_back(sample);
+    }
+    OptimizationCheckpoint::estimateDistribution(samples, checkpoint.mean,
+                                                 checkpoint.stepSize);
+    string fileName = checkpointFile;
+    writer->submit("checkpoint", [checkpoint, fileName]() {
+        checkpoint.save(fileName);
+    });
+}
+
+bool HighJumpOptimization::resume(const string& fileName,
+                                  OptimizationCheckpoint& checkpoint) {
+    if (!checkpoint.load(fileName)) return false;
+    lock_guard<mutex> lock(bestMutex);
+    stepCount = checkpoint.numEvaluations;
+    bestSolution = checkpoint.bestObjective;
+    bestControls = checkpoint.incumbent;
+    cout << "resuming from " << fileName << " after "
+         << checkpoint.numEvaluations << " evaluations, best: "
+         << -bestSolution << endl;
+    return true;
+}
+
+void HighJumpOptimization::updateBestSolution(const Vector& controls,
+                                              double f,
+                                              const Storage& states) const {
+    // Use an if statement to only store and print the results of an
+    // optimization step if it is better than a previous result.
+    {
+        lock_guard<mutex> lock(bestMutex);
+        if (!isBetter(controls, f)) return;
+    }
+
+    // The task owns copies of the controls and states, because the rollout
+    // is reused as soon as it is returned to the pool. The states are copied
+    // without holding the lock, so that the other workers are not blocked.
+    auto statesCopy = make_shared<Storage>(states);
+    lock_guard<mutex> lock(bestMutex);
+    // Another worker may have stored a better solution in the meantime.
+    if (!isBetter(controls, f)) return;
+    bestSolution = f;
+    bestControls = controls;
+    cout << "controls: " << controls << endl << "best: " << -f << std::endl;
+
+    // Only the latest best solution is printed if improvements arrive in
+    // bursts.
+    Vector snapshot = controls;
+    writer->submit("best", [this, snapshot, statesCopy]() {
+        printResults(snapshot, *statesCopy, "_Best_Par");
+    });
+}
+
+bool HighJumpOptimization::isBetter(const Vector& controls, double f) const {
+    if (f != bestSolution) return f < bestSolution;
+    return lexicographical_compare(
+            &controls[0], &controls[0] + controls.size(), &bestControls[0],
+            &bestControls[0] + bestControls.size());
+}
+
+void HighJumpOptimization::printResults(const Vector& controls,
+                                        const Storage& states,
+                                        const string& suffix) const {
+    resultController->prescribeControlForActuator(
+            "vastus", createControlFunction(controlBasis, controlDegree,
+                                            timePoints, endTime, controls));
+    resultModel->print(resultModel->getName() + suffix + ".osim");
+    states.print(resultModel->getName() + "_States" + suffix + ".sto");
+}
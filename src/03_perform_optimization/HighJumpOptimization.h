@@ -0,0 +1,325 @@
+/**
+ * @file HighJumpOptimization.h
+ *
+ * \brief Optimization problem that determines the muscle excitation of the
+ * single-legged hopping mechanism (build in 01) which maximizes the jump
+ * height.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ *         agent          <agent@local>
+ */
+#ifndef HIGH_JUMP_OPTIMIZATION_H
+#define HIGH_JUMP_OPTIMIZATION_H
+
+#include "AsyncWriter.h"
+#include "ControlBasisFunction.h"
+#include "EvaluationCache.h"
+#include "FidelityStatistics.h"
+#include "FiniteDifferenceGradient.h"
+#include "OptimizationCheckpoint.h"
+#include "OutputReducer.h"
+#include "PerturbationForce.h"
+#include "PrefixStateCache.h"
+#include "ResourcePool.h"
+#include "RolloutContext.h"
+#include "TerminationEvent.h"
+
+#include <OpenSim/OpenSim.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Settings of the hopper simulations used by the optimization.
+ */
+struct HopperSettings {
+    /** Number of independent model instances (one per worker thread). */
+    int numWorkers = 1;
+    /** Record the ForceReporter and BodyKinematics analyses during each
+     * evaluation. The objective is computed on-the-fly by an OutputReducer,
+     * thus, these analyses are only useful for inspecting the results. */
+    bool recordAnalyses = false;
+    /** Stop each simulation at the apex of the jump, i.e., when the center of
+     * mass starts falling after liftoff. */
+    bool terminateAtApex = false;
+    /** Stop a simulation after liftoff if its jump height cannot exceed the
+     * best height found so far. The bound holds only for the current flight,
+     * thus, it is used only with terminateAtApex (a later hop could be
+     * higher). The objective of such a rollout is only a lower bound, thus,
+     * under parallel evaluation the optimization path depends on the order
+     * in which the evaluations complete. The finite difference points of the
+     * gradient are always simulated completely. */
+    bool terminateWhenDominated = false;
+    /** Quantization tolerance of the controls used by the evaluation cache
+     * (zero disables the cache). Controls within the same grid cell share a
+     * cached objective, therefore, a large tolerance makes the objective
+     * depend on the evaluation order under parallel evaluation. */
+    double cacheTolerance = 0;
+    /** Maximum number of cached evaluations (least recently used are
+     * evicted). */
+    int cacheCapacity = 100000;
+    /** Optional file that keeps the cached evaluations across runs. */
+    std::string cacheFile;
+    /** Finite difference scheme of gradientFunc(). */
+    OpenSim::FiniteDifferenceGradient::Method gradientMethod =
+            OpenSim::FiniteDifferenceGradient::Forward;
+    /** Finite difference step size per parameter (empty for default steps,
+     * which are derived from the accuracy of the simulations). */
+    SimTK::Vector gradientStepSizes;
+    /** File of the periodic checkpoints (empty disables checkpoints). */
+    std::string checkpointFile;
+    /** Number of evaluations between checkpoints. The samples are recorded in
+     * the order in which the evaluations finish, thus, with parallel
+     * evaluations the checkpoint of a run is not reproducible. */
+    int checkpointInterval = 100;
+    /** Number of recent samples of the optimizer used to estimate the search
+     * distribution for the checkpoint (the CMA-ES population size). The
+     * estimate is a heuristic (see OptimizationCheckpoint). */
+    int populationSize = 8;
+    /** Resume simulations from the deepest cached state whose controls share
+     * a prefix with the evaluated controls. The integration is restarted at
+     * every knot, so that resumed and complete simulations are identical.
+     * The state at a knot is keyed on the controls up to the one that
+     * starts at the knot. Not used when recordAnalyses is true. */
+    bool usePrefixCache = false;
+    /** Maximum number of cached states. */
+    int prefixCacheCapacity = 10000;
+    /** Accuracy of the simulations (zero keeps the default of the
+     * integrator). */
+    double accuracy = 0;
+    /** Screen each candidate with a low-fidelity simulation and evaluate only
+     * the promising candidates at full accuracy. The optimizer sees the
+     * low-fidelity height of a rejected candidate minus the mean error of the
+     * audited candidates (see FidelityStatistics::getBias), capped at the best
+     * height minus screeningMargin, the threshold of the screening. This
+     * value depends on the best height at the time of the evaluation and is
+     * not stored in the evaluation cache. */
+    bool useMultiFidelity = false;
+    /** Accuracy of the low-fidelity simulations. */
+    double screeningAccuracy = 1e-2;
+    /** Fixed step size of the low-fidelity simulations (zero for adaptive
+     * steps). */
+    double screeningStepSize = 0;
+    /** A candidate is promising if its low-fidelity jump height is within
+     * this margin (m) of the best height. */
+    double screeningMargin = 0.05;
+    /** Every n-th rejected candidate is also evaluated at full accuracy, so
+     * that the error statistics are not limited to promising candidates
+     * (zero disables the audit). */
+    int screeningAuditInterval = 10;
+    /** File of the equilibrated initial state of the model (see
+     * ModelSnapshot), which is created by the first rollout and restored by
+     * the others, also across runs (empty equilibrates every rollout). */
+    std::string snapshotFile;
+    /** Stop the integration at the knots of the controls (see
+     * ControlSwitchEvent), so that the integrator does not reject steps at
+     * the discontinuities. */
+    bool useSwitchingEvents = true;
+    /** Parametrization of the controls: empty for one value per uniform time
+     * interval (piecewise constant) or the basis of a smooth function over
+     * [0, endTime] whose coefficients are the parameters ("bspline" or
+     * "bezier", see ControlBasisFunction). Smooth controls need fewer
+     * parameters and no switching events. Since a coefficient affects
+     * several intervals, the prefix cache is not used. */
+    std::string controlBasis;
+    /** Polynomial degree of the smooth controls. */
+    int controlDegree = 3;
+    /** Number of perturbation scenarios of a robust optimization (zero
+     * optimizes the unperturbed jump). Scenario k applies a PerturbationForce
+     * of seed scenarioSeed + k to the perturbed body and the objective is the
+     * mean jump height over the scenarios. Every candidate is evaluated on
+     * the same seeds (common random numbers), so that the comparison of two
+     * candidates is not dominated by the noise, and the scenarios are
+     * simulated concurrently. The prefix cache, the multi-fidelity screening
+     * and terminateWhenDominated are not used with scenarios. */
+    int numScenarios = 0;
+    /** Seed of the first scenario. */
+    int scenarioSeed = 0;
+    /** Body of the perturbation force. */
+    std::string perturbedBody = "pelvis";
+    /** Magnitude (N) of the perturbation force. */
+    double perturbationMagnitude = 20;
+};
+
+/**
+ * \brief An independent instance of the hopper model, controller and analyses.
+ *
+ * Each worker thread borrows its own rollout, therefore, rollouts can be
+ * simulated concurrently.
+ */
+class HopperRollout {
+ public:
+    HopperRollout(const std::vector<double>& timePoints, double endTime,
+                  const HopperSettings& settings,
+                  OpenSim::PrefixStateCache* prefixCache = nullptr);
+    /** Simulates the model using the given controls and returns the maximum
+     * height of the center of mass. If allowed, a high-fidelity simulation is
+     * resumed from the prefix cache. */
+    double simulate(const SimTK::Vector& controls,
+                    OpenSim::FidelityStatistics::Fidelity fidelity =
+                            OpenSim::FidelityStatistics::High,
+                    bool allowResume = true);
+    /** Wall time (s) of the last simulation. */
+    double getWallTime() const { return wallTime; }
+    /** True if the last simulation was resumed from the prefix cache, thus,
+     * the state storage holds only the simulated part. */
+    bool isResumed() const { return resumed; }
+    /** Selects the perturbation scenario by the seed of its force (only if
+     * the settings have scenarios). */
+    void setScenario(int seed);
+    /** Best jump height so far, used by terminateWhenDominated. */
+    void setIncumbent(double height) { incumbentHeight = height; }
+    /** The states of the last simulation. */
+    const OpenSim::Storage& getStateStorage() const;
+    /** Simulation context (e.g., for integrator statistics and timing). */
+    OpenSim::RolloutContext& updContext() { return *context; }
+
+ private:
+    OpenSim::Model model;
+    OpenSim::ForceReporter* forceReporter = nullptr;
+    OpenSim::BodyKinematics* bodyKinematics = nullptr;
+    OpenSim::OutputReducer* maxHeight;
+    OpenSim::PrescribedController* controller;
+    // Either piecewise constant or smooth controls.
+    OpenSim::PiecewiseConstantFunction* controlFunction = nullptr;
+    OpenSim::ControlBasisFunction* basisFunction = nullptr;
+    // Used by the perturbation scenarios, if any.
+    OpenSim::PerturbationForce* perturbation = nullptr;
+    SimTK::State state;
+    std::unique_ptr<OpenSim::RolloutContext> context;
+    // Used for the low-fidelity simulations, if any.
+    std::unique_ptr<OpenSim::RolloutContext> screeningContext;
+    OpenSim::PrefixStateCache* prefixCache;
+    SimTK::State resumeState;
+    SimTK::Vector currentControls;
+    bool resumed = false;
+    double wallTime = 0;
+    std::vector<double> timePoints;
+    double endTime;
+    double incumbentHeight = -SimTK::Infinity;
+};
+
+/**
+ * \brief Maximizes the jump height of the hopper.
+ *
+ * The objective function is thread-safe. When CMA-ES is configured to evaluate
+ * its population in parallel (advanced option "parallel"), each concurrent
+ * evaluation borrows one of the HopperSettings::numWorkers rollouts. Since
+ * every rollout starts from the same initial state, the objective value of a
+ * candidate does not depend on the worker that computed it. The values
+ * returned with terminateWhenDominated, useMultiFidelity or the evaluation
+ * cache depend on the evaluations that finished before, thus, only without
+ * them a fixed CMA-ES seed reproduces the optimization. With
+ * HopperSettings::numScenarios the objective is the expected jump height
+ * under random perturbations.
+ */
+class HighJumpOptimization : public SimTK::OptimizerSystem {
+ public:
+    HighJumpOptimization(int numParameters, double endTime,
+                         const HopperSettings& settings = HopperSettings());
+
+    int objectiveFunc(const SimTK::Vector& newControls, bool new_coefficients,
+                      SimTK::Real& f) const override;
+    /** Finite difference gradient, where the perturbed simulations are
+     * performed concurrently (one per worker). Used by gradient-based
+     * optimizers when useNumericalGradient(false). The perturbed points are
+     * evaluated exactly (see evaluate()). */
+    int gradientFunc(const SimTK::Vector& controls, bool new_coefficients,
+                     SimTK::Vector& gradient) const override;
+
+    int getNumWorkers() const { return rollouts.size(); }
+    /** Number of calls of objectiveFunc() (i.e., by the optimizer). */
+    int getNumEvaluations() const { return stepCount; }
+    double getBestObjective() const;
+    SimTK::Vector getBestControls() const;
+    /** Restores the evaluation count and the best solution from a
+     * checkpoint. Returns false if the checkpoint does not exist. The
+     * optimizer should be restarted from the checkpoint's mean and step
+     * size. */
+    bool resume(const std::string& fileName,
+                OpenSim::OptimizationCheckpoint& checkpoint);
+    /** Blocks until the results of the best solution are printed. */
+    void flushResults() const { writer->flush(); }
+    /** The evaluation cache or nullptr if disabled. */
+    const OpenSim::EvaluationCache* getCache() const { return cache.get(); }
+    /** Statistics of the multi-fidelity evaluation or nullptr if
+     * disabled. */
+    const OpenSim::FidelityStatistics* getFidelityStatistics() const {
+        return fidelityStatistics.get();
+    }
+    /** The prefix state cache or nullptr if disabled. */
+    const OpenSim::PrefixStateCache* getPrefixCache() const {
+        return prefixCache.get();
+    }
+
+ private:
+    // An exact evaluation (e.g., of a finite difference point) is neither
+    // terminated by the bound of terminateWhenDominated nor screened by the
+    // low-fidelity simulation. It is not looked up in the cache if the cache
+    // may hold lower bounds.
+    double evaluate(const SimTK::Vector& controls, bool exact = false) const;
+    // Simulates the controls at the fidelity of the settings and returns the
+    // jump height. isHighFidelity is false if the candidate was rejected by
+    // the low-fidelity screening, thus, the height is a penalized estimate
+    // (see useMultiFidelity).
+    double simulate(HopperRollout& rollout, const SimTK::Vector& controls,
+                    double bestHeight, bool& isHighFidelity) const;
+    // Simulates the controls in all perturbation scenarios concurrently and
+    // returns the mean jump height. The states of the first scenario are
+    // copied.
+    double simulateScenarios(const SimTK::Vector& controls,
+                             OpenSim::Storage& states) const;
+    // Ties of the best solution are resolved by comparing the controls, thus,
+    // for the same objective values the stored solution does not depend on
+    // the evaluation order of concurrent workers.
+    void updateBestSolution(const SimTK::Vector& controls, double f,
+                            const OpenSim::Storage& states) const;
+    // True if the solution improves on the best solution. Called with
+    // bestMutex locked.
+    bool isBetter(const SimTK::Vector& controls, double f) const;
+    // Counts a sample of the optimizer and saves a checkpoint periodically.
+    void recordEvaluation(const SimTK::Vector& controls) const;
+    // Prints the model with the given controls and the states. Called only
+    // from the writer thread.
+    void printResults(const SimTK::Vector& controls,
+                      const OpenSim::Storage& states,
+                      const std::string& suffix) const;
+
+    std::vector<double> timePoints;
+    double endTime;
+    mutable OpenSim::ResourcePool<HopperRollout> rollouts;
+    std::unique_ptr<OpenSim::EvaluationCache> cache;
+    // Shared by all rollouts.
+    std::unique_ptr<OpenSim::PrefixStateCache> prefixCache;
+    std::unique_ptr<OpenSim::FiniteDifferenceGradient> gradientEngine;
+    mutable std::mutex bestMutex;
+    mutable double bestSolution = SimTK::Infinity;
+    mutable SimTK::Vector bestControls;
+    mutable std::atomic<int> stepCount;
+    std::string checkpointFile;
+    int checkpointInterval;
+    // Ring buffer of the most recent samples.
+    mutable std::vector<SimTK::Vector> recentSamples;
+    mutable int nextSample = 0;
+    std::unique_ptr<OpenSim::FidelityStatistics> fidelityStatistics;
+    double screeningMargin;
+    int screeningAuditInterval;
+    mutable std::atomic<int> numRejected;
+    std::string controlBasis;
+    int controlDegree;
+    int numScenarios;
+    int scenarioSeed;
+    // True if the simulations are terminated by the bound of
+    // terminateWhenDominated (only with terminateAtApex and not with
+    // scenarios).
+    bool terminateWhenDominated;
+    // A model that is used only by the writer thread to print the results.
+    std::unique_ptr<OpenSim::Model> resultModel;
+    OpenSim::PrescribedController* resultController;
+    // Declared last, so that pending results are written before the
+    // result model is destroyed.
+    std::unique_ptr<OpenSim::AsyncWriter> writer;
+};
+
+#endif
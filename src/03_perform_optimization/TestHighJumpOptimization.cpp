@@ -0,0 +1,71 @@
+/**
+ * @file TestHighJumpOptimization.cpp
+ *
+ * \brief Tests the finite difference gradient of the HighJumpOptimization
+ * problem.
+ *
+ * @author agent <agent@local>
+ */
+#include "HighJumpOptimization.h"
+
+#include <OpenSim/OpenSim.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+#define PAUSE                                                                  \
+    cout << endl << "press a key to continue ..." << endl;                     \
+    getchar();
+
+void assertEqual(double actual, double expected, double tolerance,
+                 const string& message) {
+    if (abs(actual - expected) > tolerance) {
+        throw Exception(message + ": expected " + to_string(expected) +
+                        " got " + to_string(actual));
+    }
+}
+
+// The gradient at the best solution, i.e., where most perturbed points are
+// dominated by the incumbent.
+Vector computeGradient(bool terminateWhenDominated) {
+    int N = 5;
+    HopperSettings settings;
+    settings.numWorkers = ParallelExecutor::getNumProcessors();
+    // the bound is used only for single-flight rollouts
+    settings.terminateAtApex = true;
+    settings.terminateWhenDominated = terminateWhenDominated;
+    settings.cacheTolerance = 1e-10;
+    HighJumpOptimization optimization(N, 1.5, settings);
+    optimization.setParameterLimits(Vector(N, 0.01), Vector(N, 1.0));
+
+    double x[5] = {0.2, 0.9, 0.2, 0.9, 0.2};
+    Vector controls(N, x), gradient;
+    Real f;
+    optimization.objectiveFunc(controls, true, f);
+    optimization.gradientFunc(controls, true, gradient);
+    optimization.flushResults();
+    return gradient;
+}
+
+void testGradientWithDominatedTermination() {
+    Vector complete = computeGradient(false);
+    Vector bounded = computeGradient(true);
+    for (int i = 0; i < complete.size(); i++) {
+        assertEqual(bounded[i], complete[i], 1e-12, "gradient");
+    }
+    cout << "HighJumpOptimization gradient: ok" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testGradientWithDominatedTermination();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        PAUSE;
+        return -1;
+    }
+    PAUSE;
+    return 0;
+}
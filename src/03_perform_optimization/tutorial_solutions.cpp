@@ -2,10 +2,13 @@
  * @file tutorial_solutions.cpp
  *
  * \brief Perform an Optimization of controls using OpenSim model (build in 01)
- * of a single-legged hopping mechanism.
+ * of a single-legged hopping mechanism. The HighJumpOptimization problem is
+ * defined in HighJumpOptimization.h.
  *
  * @author Dimitar Stanev <jimstanev@gmail.com>
  */
+#include "HighJumpOptimization.h"
+
 #include <OpenSim/OpenSim.h>
 #include <iostream>
 
@@ -18,117 +21,37 @@ using namespace SimTK;
     cout << endl << "press a key to continue ..." << endl;                     \
     getchar();
 
-class HighJumpOptimization : public OptimizerSystem {
- public:
-    HighJumpOptimization(int numParameters, double endTime)
-            : OptimizerSystem(numParameters), endTime(endTime) {
-        // Setup model.
-        model = Model("Dennis.osim");
-
-        // Add force and body kinematics analyses in order to record the forces
-        // and body kinematics, respectively.
-        forceReporter = new ForceReporter();
-        model.addAnalysis(forceReporter);
-        bodyKinematics = new BodyKinematics();
-        model.addAnalysis(bodyKinematics);
-
-        // Create a controller to excite the vastus muscle.
-        controller = new PrescribedController();
-        controller->setActuators(model.updActuators());
-        controller->setName("brain");
-        model.addController(controller);
-
-        // Initialize model and equilibrate muscles.
-        state = model.initSystem();
-        model.equilibrateMuscles(state);
-
-        // Partition the time uniformly based on the number of parameters and
-        // final time.
-        for (int i = 0; i < numParameters; i++) {
-            timePoints.push_back(endTime / numParameters * i);
-        }
-    }
-
-    int objectiveFunc(const Vector& newControls, bool new_coefficients,
-                      Real& f) const {
-        // Initialization
-        auto workingState = state;
-        forceReporter->updForceStorage().reset(0);
-        bodyKinematics->getPositionStorage()->reset(0);
-        bodyKinematics->getAccelerationStorage()->reset(0);
-        bodyKinematics->getVelocityStorage()->reset(0);
-
-        // Update controller from newControls.
-#pragma region task_5a
-        //*/
-        int N = getNumParameters();
-        auto controlFunction = new PiecewiseConstantFunction(N, &timePoints[0],
-                                                             &newControls[0]);
-        controller->prescribeControlForActuator("vastus", controlFunction);
-        //*/
-#pragma endregion
-
-        // Create the manager for the simulation and perform the
-        // simulation.
-#pragma region task_5b
-        //*/
-        Manager manager(model);
-        manager.initialize(workingState);
-        manager.integrate(endTime);
-        //*/
-#pragma endregion
-
-        // Evaluate objective function, which is to maximize the jump height.
-        // OptimizerSystem assumese that the objective function is minimized.
-#pragma region task_5c
-        //*/
-        auto bodyPositions = bodyKinematics->getPositionStorage();
-        Array<double> CoMY;
-        bodyPositions->getDataColumn("center_of_mass_Y", CoMY);
-
-        double maxValue = 0;
-        for (int i = 0; i < CoMY.getSize(); i++) {
-            if (CoMY[i] > 0 && CoMY[i] > maxValue) { maxValue = CoMY[i]; }
-        }
-        f = -1 * maxValue;
-        //*/
-#pragma endregion
-
-        // Use an if statement to only store and print the results of an
-        // optimization step if it is better than a previous result.
-        if (f < bestSolution) {
-            bestSolution = f;
-            cout << "objective evaluation: " << stepCount << endl
-                 << "controls: " << newControls << endl
-                 << "best: " << -f << std::endl;
-
-            model.print(model.getName() + "_Best_Par.osim");
-            manager.getStateStorage().print(model.getName() +
-                                            "_States_Best_Par.sto");
-        }
-        stepCount++;
-        return 0;
-    }
-
- private:
-    mutable Model model;
-    mutable ForceReporter* forceReporter;
-    mutable BodyKinematics* bodyKinematics;
-    mutable PrescribedController* controller;
-    State state;
-    vector<double> timePoints;
-    mutable double bestSolution = Infinity, endTime;
-    mutable int stepCount = 0;
-};
-
-void performHighJumpOptimization() {
+void performHighJumpOptimization(const string& controlBasis,
+                                 int numScenarios, bool terminateAtApex) {
     // Initialize the optimizer system we've defined. Set the upper and lower
     // bounds.
 #pragma region task_6a
     //*/
     int N = 5;
     double tf = 1.5;
-    HighJumpOptimization optimizationSystem(N, tf);
+    HopperSettings settings;
+    settings.numWorkers = ParallelExecutor::getNumProcessors();
+    // The objective is the maximum height of the center of mass over [0, tf].
+    // Stopping at the first apex is faster, but ignores a higher second jump.
+    settings.terminateAtApex = terminateAtApex;
+    settings.cacheTolerance = 1e-10;
+    // The N parameters are either piecewise constant controls or the
+    // coefficients of a smooth function: a cubic B-spline with two segments
+    // or a quartic Bezier curve.
+    settings.controlBasis = controlBasis;
+    settings.controlDegree = controlBasis == "bezier" ? 4 : 3;
+    // With scenarios the controls maximize the expected jump height under
+    // random perturbations of the pelvis. The seeds are the same for all
+    // candidates.
+    settings.numScenarios = numScenarios;
+    settings.checkpointFile = "Dennis_Checkpoint";
+    if (!controlBasis.empty()) settings.checkpointFile += "_" + controlBasis;
+    if (numScenarios > 0) settings.checkpointFile += "_robust";
+    settings.checkpointFile += ".txt";
+    settings.snapshotFile = "Dennis.oss";
+    // default population size of CMA-ES
+    settings.populationSize = 4 + (int) (3 * log(N));
+    HighJumpOptimization optimizationSystem(N, tf, settings);
 
     Vector lowerBounds(N, 0.01);
     Vector upperBounds(N, 1.0);
@@ -140,6 +63,9 @@ void performHighJumpOptimization() {
     // optimization algorithm.
 #pragma region task_6b
     //*/
+    // For a gradient-based optimizer use SimTK::LBFGSB and
+    // useNumericalGradient(false), so that the finite difference gradient is
+    // computed in parallel by HighJumpOptimization::gradientFunc.
     // Optimizer opt(sys, SimTK::LBFGSB);
     Optimizer optimizer(optimizationSystem, SimTK::CMAES);
 
@@ -147,21 +73,73 @@ void performHighJumpOptimization() {
     optimizer.useNumericalGradient(true);
     optimizer.setMaxIterations(100);
 
-    // Optimize.
+    // Evaluate each CMA-ES generation in parallel, one model instance per
+    // thread. A fixed seed reproduces the candidates of CMA-ES, as long as
+    // the objective values do not depend on the order of the evaluations
+    // (see HighJumpOptimization).
+    optimizer.setAdvancedIntOption("seed", 42);
+    optimizer.setAdvancedStrOption("parallel", "multithreading");
+    optimizer.setAdvancedIntOption("nthreads", settings.numWorkers);
+    optimizer.setAdvancedIntOption("popsize", settings.populationSize);
+
+    // Warm restart from the checkpoint of an interrupted run, if any.
     Vector solution(N, 0.01);
+    OptimizationCheckpoint checkpoint;
+    if (optimizationSystem.resume(settings.checkpointFile, checkpoint)) {
+        solution = checkpoint.mean;
+        if (!isNaN(checkpoint.stepSize)) {
+            optimizer.setAdvancedRealOption("init_stepsize",
+                                            checkpoint.stepSize);
+        }
+        int generations =
+                checkpoint.numEvaluations / settings.populationSize;
+        optimizer.setMaxIterations(max(1, 100 - generations));
+    }
+
+    // Optimize.
     Real f = optimizer.optimize(solution);
+    optimizationSystem.flushResults();
+    // The optimization has finished, so it must not be resumed.
+    remove(settings.checkpointFile.c_str());
     //*/
 #pragma endregion
 
     cout << endl
          << "optimization finished" << endl
-         << "maximum CoM = " << -f << " m" << endl
+         << (numScenarios > 0 ? "expected maximum CoM = " : "maximum CoM = ")
+         << -f << " m" << endl
          << solution << endl;
+    if (auto statistics = optimizationSystem.getFidelityStatistics()) {
+        statistics->print(cout);
+    }
+    if (auto cache = optimizationSystem.getCache()) {
+        cout << "cache hits: " << cache->getNumHits()
+             << " misses: " << cache->getNumMisses() << endl;
+    }
 }
 
 int main(int argc, char* argv[]) {
     try {
-        performHighJumpOptimization();
+        // --basis bspline or --basis bezier for smooth controls and
+        // --scenarios n for a robust optimization over n perturbations and
+        // --apex to stop each simulation at the apex of the first jump
+        string controlBasis;
+        int numScenarios = 0;
+        bool terminateAtApex = false;
+        for (int i = 1; i < argc; i++) {
+            string argument = argv[i];
+            if (argument == "--basis" && i + 1 < argc) {
+                controlBasis = argv[++i];
+            } else if (argument == "--scenarios" && i + 1 < argc) {
+                numScenarios = stoi(argv[++i]);
+            } else if (argument == "--apex") {
+                terminateAtApex = true;
+            } else {
+                throw Exception("unknown argument " + argument);
+            }
+        }
+        performHighJumpOptimization(controlBasis, numScenarios,
+                                    terminateAtApex);
     } catch (exception& e) {
         cout << typeid(e).name() << ": " << e.what() << endl;
         PAUSE;
@@ -0,0 +1,148 @@
+/**
+ * @file PerturbationCampaign.cpp
+ *
+ * \brief A Monte Carlo study of the tug of war model under random
+ * perturbations.
+ *
+ * Each rollout simulates the model with a PerturbationForce of its own seed
+ * (the base seed plus the index of the rollout). The selected state variables
+ * are sampled at a fixed rate and their mean, standard deviation and 5%, 50%
+ * and 95% quantiles at each sample time are accumulated on-the-fly. The
+ * rollouts are distributed over all cores, each worker owning a model
+ * instance.
+ *
+ * Usage: PerturbationCampaign [--runs n] [--seed s] [--duration s]
+ *                             [--rate Hz] [--states name,name,...]
+ *
+ * By default the state variables of the coordinate of the block are sampled.
+ * The statistics are written to tug_of_war_Campaign.txt.
+ *
+ * @author agent <agent@local>
+ */
+#include "ModelSnapshot.h"
+#include "MonteCarloCampaign.h"
+#include "ParallelTasks.h"
+#include "PerturbationForce.h"
+#include "ResourcePool.h"
+#include "RolloutContext.h"
+
+#include <OpenSim/OpenSim.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace OpenSim;
+
+/** Options of the campaign, set from the command line. */
+struct CampaignOptions {
+    int numRuns = 1000;
+    int baseSeed = 0;
+    double duration = 1;
+    double sampleRate = 100;
+    vector<string> states;
+};
+
+/** A model instance that is borrowed by one worker thread at a time. */
+struct CampaignWorker {
+    Model model;
+    PerturbationForce* force;
+    SimTK::State state;
+    unique_ptr<RolloutContext> context;
+};
+
+void performCampaign(CampaignOptions options) {
+    // The sample times are the report times of the rollouts, including the
+    // initial time.
+    double interval = 1 / options.sampleRate;
+    int numSamples = int(floor(options.duration / interval + 1e-9)) + 1;
+    vector<double> sampleTimes;
+    for (int k = 0; k < numSamples; k++) sampleTimes.push_back(k * interval);
+
+    ResourcePool<CampaignWorker> workers;
+    for (int i = 0; i < getDefaultNumThreads(); i++) {
+        unique_ptr<CampaignWorker> worker(new CampaignWorker());
+        // The file is parsed once and copied for each worker.
+        worker->model = ModelSnapshot::loadModel("tug_of_war.osim");
+        worker->force = new PerturbationForce();
+        worker->force->setName("noise");
+        worker->force->set_body_name("block");
+        worker->force->set_magnitude(1000);
+        worker->model.addForce(worker->force);
+        worker->state = worker->model.initSystem();
+        if (options.states.empty()) {
+            auto names = worker->model.getStateVariableNames();
+            for (int j = 0; j < names.getSize(); j++) {
+                if (names[j].find("block_tz") != string::npos) {
+                    options.states.push_back(names[j]);
+                }
+            }
+        }
+        worker->context.reset(new RolloutContext(worker->model));
+        worker->context->setReportInterval(interval);
+        worker->context->setRecordedStates(options.states);
+        workers.add(move(worker));
+    }
+
+    MonteCarloCampaign campaign(sampleTimes, options.states);
+    int numOutputs = int(options.states.size());
+    auto start = chrono::steady_clock::now();
+    campaign.run(options.numRuns, [&](int i, vector<double>& samples) {
+        auto worker = workers.acquire();
+        worker->force->setSeed(options.baseSeed + i);
+        worker->context->simulate(worker->state, options.duration);
+        const auto& states = worker->context->getStateStorage();
+        if (states.getSize() != numSamples) {
+            throw Exception("rollout " + to_string(i) + " recorded " +
+                            to_string(states.getSize()) + " samples");
+        }
+        for (int k = 0; k < numSamples; k++) {
+            const auto& values = states.getStateVector(k)->getData();
+            for (int j = 0; j < numOutputs; j++) {
+                samples[k * numOutputs + j] = values[j];
+            }
+        }
+    });
+    double wallTime =
+            chrono::duration<double>(chrono::steady_clock::now() - start)
+                    .count();
+
+    cout << campaign.getNumRuns() << " rollouts in " << wallTime << " s ("
+         << campaign.getNumFailures() << " failed)" << endl;
+    if (campaign.getNumFailures() > 0) {
+        cout << "first error: " << campaign.getFirstError() << endl;
+    }
+    campaign.printResults("tug_of_war_Campaign.txt");
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        CampaignOptions options;
+        for (int i = 1; i < argc; i++) {
+            string argument = argv[i];
+            if (argument == "--runs" && i + 1 < argc) {
+                options.numRuns = stoi(argv[++i]);
+            } else if (argument == "--seed" && i + 1 < argc) {
+                options.baseSeed = stoi(argv[++i]);
+            } else if (argument == "--duration" && i + 1 < argc) {
+                options.duration = stod(argv[++i]);
+            } else if (argument == "--rate" && i + 1 < argc) {
+                options.sampleRate = stod(argv[++i]);
+            } else if (argument == "--states" && i + 1 < argc) {
+                istringstream names(argv[++i]);
+                string name;
+                while (getline(names, name, ',')) {
+                    options.states.push_back(name);
+                }
+            } else {
+                throw Exception("unknown argument " + argument);
+            }
+        }
+        performCampaign(options);
+    } catch (exception& e) {
+        cout << typeid(e).name() << ": " << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
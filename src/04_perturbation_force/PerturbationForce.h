@@ -10,12 +10,21 @@
 #define PERTURBATION_FORCE_H
 
 #include "PerturbationForceExports.h"
+#include "PerturbationNoise.h"
 
 #include <OpenSim/Simulation/Model/Force.h>
 
 namespace OpenSim {
+class Body;
 /**
  * \brief Implements a body force of random direction and constant magnitude.
+ *
+ * The direction is a smooth random function of time (see PerturbationNoise)
+ * that is determined by the seed, therefore, a simulation is reproducible,
+ * independent of the steps of the integrator and instances can be simulated
+ * concurrently. Forces with different seeds perturb independently. The body is
+ * bound when the model is connected, while the seed is read when the force is
+ * computed.
  */
 class PerturbationForce_API PerturbationForce : public OpenSim::Force {
     OpenSim_DECLARE_CONCRETE_OBJECT(PerturbationForce, OpenSim::Force);
@@ -27,13 +36,29 @@ class PerturbationForce_API PerturbationForce : public OpenSim::Force {
                              "Point of application in body frame.");
     OpenSim_DECLARE_PROPERTY(magnitude, double,
                              "Magnitude of the perturbation force.");
+    OpenSim_DECLARE_PROPERTY(seed, int, "Seed of the random direction.");
+    OpenSim_DECLARE_PROPERTY(cutoff_frequency, double,
+                             "Bandwidth (Hz) of the changes of the "
+                             "direction.");
     PerturbationForce();
 
+    /** Changes the seed, e.g., between the rollouts of a Monte Carlo
+     * campaign. The seed is read in computeForce, so the model need not be
+     * initialized again. */
+    void setSeed(int seed) { set_seed(seed); }
+    /** The generator of the direction. */
+    PerturbationNoise getNoise() const {
+        return PerturbationNoise(uint64_t(get_seed()), get_cutoff_frequency());
+    }
+
  protected:
     void computeForce(const SimTK::State& state,
                       SimTK::Vector_<SimTK::SpatialVec>& bodyForces,
                       SimTK::Vector& generalizedForces) const override;
-    void extendConnectToModel(Model& model);
+    void extendConnectToModel(Model& model) override;
+
+ private:
+    SimTK::ReferencePtr<const Body> body;
 };
 } // namespace OpenSim
 
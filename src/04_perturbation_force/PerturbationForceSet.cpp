@@ -0,0 +1,92 @@
+#include "PerturbationForceSet.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenSim;
+
+PerturbationForceSet::PerturbationForceSet() {
+    constructProperty_body_names();
+    constructProperty_offsets();
+    constructProperty_magnitudes();
+    constructProperty_seed(0);
+    constructProperty_cutoff_frequency(10);
+}
+
+void PerturbationForceSet::addPerturbation(const std::string& bodyName,
+                                           const SimTK::Vec3& offset,
+                                           double magnitude) {
+    // missing offsets of earlier perturbations are zero
+    while (getProperty_offsets().size() < getProperty_body_names().size()) {
+        append_offsets(SimTK::Vec3(0));
+    }
+    append_body_names(bodyName);
+    append_offsets(offset);
+    append_magnitudes(magnitude);
+}
+
+void PerturbationForceSet::extendFinalizeFromProperties() {
+    Super::extendFinalizeFromProperties();
+    int n = getProperty_body_names().size();
+    if (getProperty_magnitudes().size() != n) {
+        throw Exception("PerturbationForceSet: magnitudes must have one "
+                        "value per body");
+    }
+    if (getProperty_offsets().size() != 0 &&
+        getProperty_offsets().size() != n) {
+        throw Exception("PerturbationForceSet: offsets must be empty or have "
+                        "one value per body");
+    }
+    offsets.assign(n, SimTK::Vec3(0));
+    magnitudes.resize(n);
+    for (int i = 0; i < n; i++) {
+        if (getProperty_offsets().size() != 0) offsets[i] = get_offsets(i);
+        magnitudes[i] = get_magnitudes(i);
+    }
+}
+
+void PerturbationForceSet::extendConnectToModel(Model& model) {
+    Super::extendConnectToModel(model);
+    const auto& bodySet = model.getBodySet();
+    bodies.clear();
+    for (int i = 0; i < getProperty_body_names().size(); i++) {
+        if (!bodySet.contains(get_body_names(i))) {
+            auto errorMessage = "Invalid body_names:" + get_body_names(i);
+            throw Exception(errorMessage.c_str());
+        }
+        bodies.emplace_back(&bodySet.get(get_body_names(i)));
+    }
+}
+
+void PerturbationForceSet::computeForce(
+        const SimTK::State& state,
+        SimTK::Vector_<SimTK::SpatialVec>& bodyForces,
+        SimTK::Vector& generalizedForces) const {
+    // The signals of a block of perturbations are kept on the stack, so that
+    // concurrent evaluations do not share a buffer.
+    const int blockSize = 16;
+    double d[3 * blockSize];
+    auto noise = getNoise();
+    int n = int(bodies.size());
+    for (int first = 0; first < n; first += blockSize) {
+        int m = std::min(blockSize, n - first);
+        noise.getValues(3 * uint64_t(first), 3 * m, state.getTime(), d);
+        // scale the signals of each perturbation to a vector of its magnitude
+        for (int i = 0; i < m; i++) {
+            double norm = std::sqrt(d[3 * i] * d[3 * i] +
+                                    d[3 * i + 1] * d[3 * i + 1] +
+                                    d[3 * i + 2] * d[3 * i + 2]);
+            double scale = norm > 0 ? magnitudes[first + i] / norm : 0;
+            d[3 * i] *= scale;
+            d[3 * i + 1] *= scale;
+            d[3 * i + 2] *= scale;
+        }
+        for (int i = 0; i < m; i++) {
+            SimTK::Vec3 perturbationForceInG(d[3 * i], d[3 * i + 1],
+                                             d[3 * i + 2]);
+            applyForceToPoint(state, *bodies[first + i], offsets[first + i],
+                              perturbationForceInG, bodyForces);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * @file PerturbationForceSet.h
+ *
+ * \brief Applies independent perturbation forces to many bodies from a single
+ * force component.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef PERTURBATION_FORCE_SET_H
+#define PERTURBATION_FORCE_SET_H
+
+#include "PerturbationForceExports.h"
+#include "PerturbationNoise.h"
+
+#include <OpenSim/Simulation/Model/Force.h>
+#include <vector>
+
+namespace OpenSim {
+class Body;
+/**
+ * \brief Implements a set of body forces of random direction and constant
+ * magnitude (one PerturbationForce per entry of body_names).
+ *
+ * Perturbation i acts on body_names[i] at offsets[i] (zero if offsets is empty)
+ * with magnitudes[i]. Its direction is generated from the streams 3 i, 3 i + 1
+ * and 3 i + 2 of the noise, therefore, the perturbations are independent and
+ * the first one is identical to a PerturbationForce of the same seed.
+ *
+ * The bodies are bound when the model is connected and the offsets and
+ * magnitudes are kept in contiguous arrays, while the seed is read when the
+ * forces are computed. The directions are generated in
+ * blocks of perturbations on the stack, where the streams of a block share the
+ * interpolation weights (the knots are still a hash of the seed, the stream
+ * and the counter, so that the evaluation needs no mutable state). Thus, a
+ * model with many perturbed segments pays the overhead of a single
+ * component.
+ */
+class PerturbationForce_API PerturbationForceSet : public OpenSim::Force {
+    OpenSim_DECLARE_CONCRETE_OBJECT(PerturbationForceSet, OpenSim::Force);
+
+ public:
+    OpenSim_DECLARE_LIST_PROPERTY(body_names, std::string,
+                                  "Bodies to apply the forces.");
+    OpenSim_DECLARE_LIST_PROPERTY(offsets, SimTK::Vec3,
+                                  "Points of application in body frame "
+                                  "(zero if empty).");
+    OpenSim_DECLARE_LIST_PROPERTY(magnitudes, double,
+                                  "Magnitudes of the perturbation forces.");
+    OpenSim_DECLARE_PROPERTY(seed, int, "Seed of the random directions.");
+    OpenSim_DECLARE_PROPERTY(cutoff_frequency, double,
+                             "Bandwidth (Hz) of the changes of the "
+                             "directions.");
+    PerturbationForceSet();
+
+    /** Appends a perturbation (before the model is finalized). */
+    void addPerturbation(const std::string& bodyName,
+                         const SimTK::Vec3& offset, double magnitude);
+    int getNumPerturbations() const { return getProperty_body_names().size(); }
+    /** Changes the seed, e.g., between the rollouts of a Monte Carlo
+     * campaign. The seed is read in computeForce, so the model need not be
+     * initialized again. */
+    void setSeed(int seed) { set_seed(seed); }
+    /** The generator of the directions. */
+    PerturbationNoise getNoise() const {
+        return PerturbationNoise(uint64_t(get_seed()), get_cutoff_frequency());
+    }
+
+ protected:
+    void computeForce(const SimTK::State& state,
+                      SimTK::Vector_<SimTK::SpatialVec>& bodyForces,
+                      SimTK::Vector& generalizedForces) const override;
+    void extendFinalizeFromProperties() override;
+    void extendConnectToModel(Model& model) override;
+
+ private:
+    std::vector<SimTK::ReferencePtr<const Body>> bodies;
+    std::vector<SimTK::Vec3> offsets;
+    std::vector<double> magnitudes;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,71 @@
+#include "PerturbationNoise.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <cmath>
+
+using namespace OpenSim;
+
+namespace {
+// Finalizer of SplitMix64, a bijective mixing of the bits.
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+} // namespace
+
+PerturbationNoise::PerturbationNoise(uint64_t seed, double cutoffFrequency)
+        : seed(seed), cutoffFrequency(cutoffFrequency) {
+    if (!(cutoffFrequency > 0)) {
+        throw Exception("PerturbationNoise: cutoff frequency must be positive");
+    }
+    knotInterval = 0.5 / cutoffFrequency;
+}
+
+double PerturbationNoise::uniform(uint64_t seed, uint64_t stream,
+                                  uint64_t counter) {
+    uint64_t x = mix(mix(mix(seed) ^ stream) ^ counter);
+    // the upper 53 bits, shifted into the open interval
+    return (double(x >> 11) + 0.5) / 9007199254740992.0;
+}
+
+double PerturbationNoise::gaussian(uint64_t seed, uint64_t stream,
+                                   uint64_t counter) {
+    double u1 = uniform(seed, stream, 2 * counter);
+    double u2 = uniform(seed, stream, 2 * counter + 1);
+    return std::sqrt(-2 * std::log(u1)) * std::cos(2 * SimTK::Pi * u2);
+}
+
+double PerturbationNoise::getValue(uint64_t stream, double t) const {
+    double value;
+    getValues(stream, 1, t, &value);
+    return value;
+}
+
+void PerturbationNoise::getValues(uint64_t firstStream, int numStreams,
+                                  double t, double* values) const {
+    double u = t / knotInterval;
+    double k = std::floor(u);
+    double s = u - k;
+    // weights of the uniform cubic B-spline on knots k - 1 to k + 2
+    double s2 = s * s, s3 = s2 * s;
+    const double weights[4] = {(1 - s) * (1 - s) * (1 - s) / 6,
+                               (3 * s3 - 6 * s2 + 4) / 6,
+                               (-3 * s3 + 3 * s2 + 3 * s + 1) / 6, s3 / 6};
+    auto first = uint64_t(int64_t(k) - 1);
+    for (int i = 0; i < numStreams; i++) {
+        double value = 0;
+        for (int j = 0; j < 4; j++) {
+            value += weights[j] * gaussian(seed, firstStream + i, first + j);
+        }
+        values[i] = value;
+    }
+}
+
+SimTK::Vec3 PerturbationNoise::getDirection(double t) const {
+    SimTK::Vec3 value;
+    getValues(0, 3, t, &value[0]);
+    double norm = value.norm();
+    return norm > 0 ? value / norm : SimTK::Vec3(0);
+}
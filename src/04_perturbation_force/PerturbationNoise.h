@@ -0,0 +1,61 @@
+/**
+ * @file PerturbationNoise.h
+ *
+ * \brief A reproducible, smooth random signal that is a deterministic function
+ * of time (used by PerturbationForce).
+ *
+ * @author agent <agent@local>
+ */
+#ifndef PERTURBATION_NOISE_H
+#define PERTURBATION_NOISE_H
+
+#include "PerturbationForceExports.h"
+
+#include <SimTKcommon.h>
+#include <cstdint>
+
+namespace OpenSim {
+/**
+ * \brief Band-limited Gaussian noise generated from counter-based random
+ * streams.
+ *
+ * The random numbers are a hash of the seed, the stream (e.g., the axis) and
+ * the counter (the index of a knot), thus, they need no generator state:
+ * evaluations are thread-safe, do not depend on the order of the calls (e.g.,
+ * rejected steps of the integrator) and any knot can be computed in constant
+ * time. The knots are spaced by half the period of the cutoff frequency and
+ * interpolated by a uniform cubic B-spline, so that the signal is twice
+ * continuously differentiable and its spectrum decays above the cutoff
+ * frequency.
+ */
+class PerturbationForce_API PerturbationNoise {
+ public:
+    PerturbationNoise(uint64_t seed = 0, double cutoffFrequency = 10);
+
+    uint64_t getSeed() const { return seed; }
+    double getCutoffFrequency() const { return cutoffFrequency; }
+
+    /** Smooth signal of the stream at time t. */
+    double getValue(uint64_t stream, double t) const;
+    /** Signals of the streams firstStream to firstStream + numStreams - 1 at
+     * time t. The interpolation weights are shared by all streams. */
+    void getValues(uint64_t firstStream, int numStreams, double t,
+                   double* values) const;
+    /** Unit vector of the signals of the streams 0, 1 and 2 at time t (an
+     * isotropic random direction). */
+    SimTK::Vec3 getDirection(double t) const;
+
+    /** Uniformly distributed number in (0, 1) of a counter of a stream. */
+    static double uniform(uint64_t seed, uint64_t stream, uint64_t counter);
+    /** Standard normal number of a counter of a stream (Box-Muller transform
+     * of two uniform numbers). */
+    static double gaussian(uint64_t seed, uint64_t stream, uint64_t counter);
+
+ private:
+    uint64_t seed;
+    double cutoffFrequency;
+    double knotInterval;
+};
+} // namespace OpenSim
+
+#endif
@@ -1,6 +1,7 @@
 #include "RegisterPlugin.h"
 
 #include "PerturbationForce.h"
+#include "PerturbationForceSet.h"
 
 #include <OpenSim/Common/Object.h>
 
@@ -8,7 +9,10 @@ using namespace OpenSim;
 
 static dllObjectInstantiator instantiator;
 
-void RegisterPlugin() { Object::RegisterType(PerturbationForce()); }
+void RegisterPlugin() {
+    Object::RegisterType(PerturbationForce());
+    Object::RegisterType(PerturbationForceSet());
+}
 
 dllObjectInstantiator::dllObjectInstantiator() { registerDllClasses(); }
 
@@ -5,7 +5,9 @@
  *
  * @author Dimitar Stanev <jimstanev@gmail.com>
  */
+#include "AsyncVisualizer.h"
 #include "PerturbationForce.h"
+#include "PerturbationForceSet.h"
 
 #include <OpenSim/OpenSim.h>
 #include <iostream>
@@ -17,20 +19,92 @@ using namespace OpenSim;
     cout << endl << "press a key to continue ..." << endl;                     \
     getchar();
 
+// The noise is a smooth, reproducible function of time.
+void testNoise() {
+    PerturbationNoise noise(1, 10), same(1, 10), other(2, 10);
+    double h = 1e-4;
+    for (double t = 0; t < 1; t += 0.01) {
+        if (noise.getValue(0, t) != same.getValue(0, t)) {
+            throw Exception("noise is not reproducible");
+        }
+        if (noise.getValue(0, t) == other.getValue(0, t)) {
+            throw Exception("noise does not depend on the seed");
+        }
+        if (abs(noise.getValue(0, t + h) - noise.getValue(0, t)) > 0.01) {
+            throw Exception("noise is not continuous");
+        }
+        if (abs(noise.getDirection(t).norm() - 1) > 1e-12) {
+            throw Exception("direction is not a unit vector");
+        }
+    }
+}
+
+// A set with one perturbation applies the same force as a PerturbationForce of
+// the same seed.
+void testPerturbationForceSet() {
+    PerturbationNoise noise(1, 10);
+    double values[6];
+    noise.getValues(0, 6, 0.37, values);
+    for (int i = 0; i < 6; i++) {
+        if (values[i] != noise.getValue(i, 0.37)) {
+            throw Exception("streams of getValues are inconsistent");
+        }
+    }
+
+    auto computeBodyForces = [](Force* force) {
+        Model model("tug_of_war.osim");
+        model.addForce(force);
+        auto state = model.initSystem();
+        state.setTime(0.37);
+        model.realizeDynamics(state);
+        return model.getMultibodySystem().getRigidBodyForces(
+                state, SimTK::Stage::Dynamics);
+    };
+    auto perturbationForce = new PerturbationForce();
+    perturbationForce->set_body_name("block");
+    perturbationForce->set_magnitude(1000);
+    perturbationForce->set_seed(1);
+    auto perturbationForceSet = new PerturbationForceSet();
+    perturbationForceSet->addPerturbation("block", SimTK::Vec3(0), 1000);
+    perturbationForceSet->set_seed(1);
+    auto expected = computeBodyForces(perturbationForce);
+    auto actual = computeBodyForces(perturbationForceSet);
+    for (int i = 0; i < expected.size(); i++) {
+        for (int j = 0; j < 2; j++) {
+            if ((actual[i][j] - expected[i][j]).norm() > 1e-9) {
+                throw Exception("PerturbationForceSet differs from "
+                                "PerturbationForce");
+            }
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
     try {
+        testNoise();
+        testPerturbationForceSet();
+        // --async-visualizer or --headless (e.g., for batch runs)
+        auto visualization = getVisualizationMode(argc, argv);
         Model model("tug_of_war.osim");
-        model.setUseVisualizer(true);
+        model.setUseVisualizer(visualization == VisualizationMode::Inline);
         // force
         auto perturbationForce = new PerturbationForce();
         perturbationForce->setName("noise");
         perturbationForce->set_body_name("block");
         perturbationForce->set_offset(SimTK::Vec3(0, 0, 0));
         perturbationForce->set_magnitude(1000);
+        perturbationForce->set_seed(1);
+        perturbationForce->set_cutoff_frequency(10);
         model.addForce(perturbationForce);
+        unique_ptr<AsyncVisualizer> asyncVisualizer;
+        if (visualization == VisualizationMode::Async) {
+            asyncVisualizer.reset(new AsyncVisualizer(model));
+        }
         // simulation
         auto state = model.initSystem();
+        if (asyncVisualizer) asyncVisualizer->start(state);
         simulate(model, state, 1, true);
+        if (asyncVisualizer) asyncVisualizer->stop();
         // output
         model.print("output_model.osim");
     } catch (exception& e) {
@@ -12,7 +12,9 @@
  * @see <a href="https://simtk.org/projects/eye">[SimTK Project]</a>, <a
  * href="https://arxiv.org/abs/1807.07332">[Publication]</a>
  */
+#include "AsyncVisualizer.h"
 #include "FixationController.h"
+#include "ModelSnapshot.h"
 
 #include <OpenSim/OpenSim.h>
 #include <iostream>
@@ -56,10 +58,11 @@ void addExpressionCoordinateForce(Model* model) {
     model->addForce(inc_exc_tissue);
 }
 
-void simulateModel() {
-    Model model("UPAT_Eye_Model_Passive_Pulleys_v2.osim");
+void simulateModel(VisualizationMode visualization, bool useSnapshot) {
+    const string sourceFile = "UPAT_Eye_Model_Passive_Pulleys_v2.osim";
+    Model model(sourceFile);
     model.setName("UPAT_Eye_Model_Passive_Pulleys_v4");
-    model.setUseVisualizer(true);
+    model.setUseVisualizer(visualization == VisualizationMode::Inline);
 
     // Add expression based coordinate force
     addExpressionCoordinateForce(&model);
@@ -79,11 +82,30 @@ void simulateModel() {
     controller->set_saccade_velocity(100); // deg / s
     model.addController(controller);
 
+    // Visualize on a render thread that does not block the simulation
+    unique_ptr<AsyncVisualizer> asyncVisualizer;
+    if (visualization == VisualizationMode::Async) {
+        asyncVisualizer.reset(new AsyncVisualizer(model));
+    }
+
     // Build and initialize model
     auto& state = model.initSystem();
-    model.equilibrateMuscles(state);
-    model.updVisualizer().updSimbodyVisualizer().setGroundHeight(-1);
-    model.updVisualizer().updSimbodyVisualizer().setBackgroundColor(Vec3(1));
+    if (useSnapshot) {
+        // restore the equilibrated state (or create the snapshot)
+        ModelSnapshot::equilibrateMuscles(model, state, sourceFile,
+                                          model.getName() + ".oss");
+    } else {
+        model.equilibrateMuscles(state);
+    }
+    auto configure = [](SimTK::Visualizer& viz) {
+        viz.setGroundHeight(-1);
+        viz.setBackgroundColor(Vec3(1));
+    };
+    if (visualization == VisualizationMode::Inline) {
+        configure(model.updVisualizer().updSimbodyVisualizer());
+    } else if (asyncVisualizer) {
+        asyncVisualizer->start(state, configure);
+    }
 
     // Create the manager for the simulation
     Manager manager(model);
@@ -91,6 +113,7 @@ void simulateModel() {
     // Integrate from initial time to final time
     manager.initialize(state);
     manager.integrate(1.0);
+    if (asyncVisualizer) asyncVisualizer->stop();
 
     // Save simulation results
     model.printControlStorage(model.getName() + "_Controls_v4.sto");
@@ -100,7 +123,13 @@ void simulateModel() {
 
 int main(int argc, char* argv[]) {
     try {
-        simulateModel();
+        // --async-visualizer or --headless (e.g., for batch runs) and
+        // --snapshot to restore the equilibrated state from a file
+        bool useSnapshot = false;
+        for (int i = 1; i < argc; i++) {
+            if (string(argv[i]) == "--snapshot") useSnapshot = true;
+        }
+        simulateModel(getVisualizationMode(argc, argv), useSnapshot);
     } catch (exception& e) {
         cout << typeid(e).name() << ": " << e.what() << endl;
         PAUSE;
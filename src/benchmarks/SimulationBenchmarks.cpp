@@ -0,0 +1,598 @@
+/**
+ * @file SimulationBenchmarks.cpp
+ *
+ * \brief Measures the throughput of standard simulation scenarios of the
+ * tutorials and, optionally, compares them against a baseline.
+ *
+ * For each scenario the wall time, the integrator statistics (steps, rejected
+ * steps and realizations, i.e., evaluations of the right hand side) and the
+ * peak resident set size are printed as CSV. The wall time of a scenario is
+ * the minimum over the repetitions and excludes the loading of the models,
+ * unless loading is the measured operation. The
+ * perturbation_compute_force scenarios are microbenchmarks of a fixed number of
+ * computeForce calls on models with an increasing number of bodies.
+ *
+ * Each scenario is run in a separate process (this program with --scenario),
+ * because the peak resident set size of a process never decreases. Thus, the
+ * peak of a scenario includes the libraries and the repetitions of that
+ * scenario only. If the process cannot be started, the remaining scenarios run
+ * in this process and their peak is not isolated.
+ *
+ * Usage: SimulationBenchmarks [--repeat n] [--output file.csv]
+ *                             [--baseline file.csv] [--tolerance 0.1]
+ *                             [--scenario name]
+ *
+ * With a baseline, a scenario whose wall time exceeds the baseline by more
+ * than the relative tolerance is reported as a regression and the program
+ * returns a non-zero exit code.
+ *
+ * @author agent <agent@local>
+ */
+#include "ControlSwitchEvent.h"
+#include "FixationController.h"
+#include "HighJumpOptimization.h"
+#include "ModelSnapshot.h"
+#include "Neuron.h"
+#include "PerturbationForce.h"
+#include "PerturbationForceSet.h"
+#include "RolloutContext.h"
+
+#include <OpenSim/OpenSim.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+#endif
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+typedef chrono::steady_clock Clock;
+
+/** The measurements of a scenario. */
+struct Measurement {
+    double wallTime = 0;
+    int numSteps = 0;
+    int numRejectedSteps = 0;
+    int numRealizations = 0;
+};
+
+/** A scenario performs its setup and measures only the operation of
+ * interest. */
+typedef function<Measurement()> Scenario;
+
+double elapsed(Clock::time_point start) {
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Peak resident set size of the process (kB) or -1 if unavailable. The peak
+// includes everything done by the process so far.
+long getPeakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return -1;
+    }
+    return long(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+    return long(usage.ru_maxrss / 1024); // bytes
+#else
+    return long(usage.ru_maxrss); // kB
+#endif
+#endif
+}
+
+// Simulates an initialized model with a RolloutContext, which provides the
+// integrator statistics.
+Measurement simulate(Model& model, const State& state, double finalTime,
+                     double maximumStepSize = 0) {
+    RolloutContext context(model);
+    if (maximumStepSize > 0) context.setMaximumStepSize(maximumStepSize);
+    context.simulate(state, finalTime);
+    Measurement measurement;
+    measurement.wallTime =
+            context.getSetupTime() + context.getIntegrationTime();
+    measurement.numSteps = context.getNumStepsTaken();
+    measurement.numRejectedSteps = context.getNumRejectedSteps();
+    measurement.numRealizations = context.getNumRealizations();
+    return measurement;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// scenarios
+
+Measurement dennisInitSystem() {
+    Measurement measurement;
+    auto start = Clock::now();
+    Model model("Dennis.osim");
+    model.initSystem();
+    measurement.wallTime = elapsed(start);
+    return measurement;
+}
+
+Measurement dennisEquilibrateMuscles() {
+    Model model("Dennis.osim");
+    auto& state = model.initSystem();
+    Measurement measurement;
+    auto start = Clock::now();
+    model.equilibrateMuscles(state);
+    measurement.wallTime = elapsed(start);
+    return measurement;
+}
+
+// Restores the equilibrated state of dennis_equilibrate_muscles from a
+// snapshot file (created beforehand).
+Measurement dennisRestoreSnapshot() {
+    Model model("Dennis.osim");
+    auto& state = model.initSystem();
+    ModelSnapshot::equilibrateMuscles(model, state, "Dennis.osim",
+                                      "Dennis_Benchmark.oss");
+    Measurement measurement;
+    auto start = Clock::now();
+    ModelSnapshot::equilibrateMuscles(model, state, "Dennis.osim",
+                                      "Dennis_Benchmark.oss");
+    measurement.wallTime = elapsed(start);
+    return measurement;
+}
+
+// The hop of 02_run_simulation, optionally with the switching events of the
+// excitation.
+Measurement dennisHop(double finalTime, bool switchingEvents = false) {
+    Model model("Dennis.osim");
+    auto brain = new PrescribedController();
+    brain->setActuators(model.updActuators());
+    double t[3] = {0.0, 1.0, 1.5}, x[3] = {0.1, 1.0, 0.1};
+    brain->prescribeControlForActuator(
+            "vastus", new PiecewiseConstantFunction(3, t, x));
+    brain->setName("brain");
+    model.addController(brain);
+    model.buildSystem();
+    if (switchingEvents) ControlSwitchEvent::addToModel(model);
+    auto& state = model.initializeState();
+    model.equilibrateMuscles(state);
+    return simulate(model, state, finalTime);
+}
+
+// An objective evaluation of HighJumpOptimization (as in
+// 03_perform_optimization).
+Measurement highJumpEvaluation() {
+    int N = 5;
+    double tf = 1.5;
+    vector<double> timePoints;
+    for (int i = 0; i < N; i++) timePoints.push_back(tf / N * i);
+    HopperSettings settings;
+    HopperRollout rollout(timePoints, tf, settings);
+    Vector controls(N, 0.5);
+    rollout.simulate(controls);
+    auto& context = rollout.updContext();
+    Measurement measurement;
+    measurement.wallTime =
+            context.getSetupTime() + context.getIntegrationTime();
+    measurement.numSteps = context.getNumStepsTaken();
+    measurement.numRejectedSteps = context.getNumRejectedSteps();
+    measurement.numRealizations = context.getNumRealizations();
+    return measurement;
+}
+
+// The test of 04_perturbation_force.
+Measurement tugOfWarPerturbation() {
+    Model model("tug_of_war.osim");
+    auto perturbationForce = new PerturbationForce();
+    perturbationForce->setName("noise");
+    perturbationForce->set_body_name("block");
+    perturbationForce->set_offset(Vec3(0));
+    perturbationForce->set_magnitude(1000);
+    model.addForce(perturbationForce);
+    auto& state = model.initSystem();
+    return simulate(model, state, 1);
+}
+
+// Exposes the protected computeForce of a force for the microbenchmark.
+template <typename T> class ForceProbe : public T {
+ public:
+    using T::computeForce;
+};
+
+// Number of computeForce calls of a microbenchmark.
+const int numForceEvaluations = 100000;
+
+void setPerturbedBody(PerturbationForce& force, const string& body) {
+    force.set_body_name(body);
+    force.set_magnitude(1000);
+}
+
+void setPerturbedBody(PerturbationForceSet& force, const string& body) {
+    force.addPerturbation(body, Vec3(0), 1000);
+}
+
+// Measures numForceEvaluations calls of computeForce of a force that perturbs
+// the last of numBodies bodies, so that a cost that grows with the number of
+// bodies (e.g., a lookup by name) shows up.
+template <typename T>
+Measurement perturbationComputeForce(int numBodies) {
+    Model model;
+    string lastBody;
+    for (int i = 0; i < numBodies; i++) {
+        lastBody = "body_" + to_string(i);
+        auto body = new OpenSim::Body(lastBody, 1, Vec3(0), Inertia(1));
+        auto joint = new PinJoint("joint_" + to_string(i), model.getGround(),
+                                  Vec3(0), Vec3(0), *body, Vec3(0, 1, 0),
+                                  Vec3(0));
+        model.addBody(body);
+        model.addJoint(joint);
+    }
+    auto force = new ForceProbe<T>();
+    force->setName("noise");
+    setPerturbedBody(*force, lastBody);
+    model.addForce(force);
+    auto& state = model.initSystem();
+    state.setTime(0.37);
+    model.realizePosition(state);
+    Vector_<SpatialVec> bodyForces(
+            model.getMatterSubsystem().getNumBodies(), SpatialVec(Vec3(0)));
+    Vector generalizedForces(state.getNU(), 0.0);
+    Measurement measurement;
+    auto start = Clock::now();
+    for (int k = 0; k < numForceEvaluations; k++) {
+        force->computeForce(state, bodyForces, generalizedForces);
+    }
+    measurement.wallTime = elapsed(start);
+    return measurement;
+}
+
+// The saccade of 05_eye_fixation_controller.
+Measurement eyeSaccade() {
+    Model model("UPAT_Eye_Model_Passive_Pulleys_v2.osim");
+    // replace the linear tissue forces (see TestFixationController)
+    auto& forces = model.updForceSet();
+    const vector<pair<string, string>> tissues = {
+            {"add_adb_tissue", "r_eye_add_abd"},
+            {"sup_inf_tissue", "r_eye_sup_inf"},
+            {"inc_exc_tissue", "r_eye_inc_exc"}};
+    for (const auto& tissue : tissues) {
+        forces.remove(forces.getIndex(&forces.get(tissue.first), 0));
+        auto force = new ExpressionBasedCoordinateForce(
+                tissue.second, "-0.002225*q-34.5297*0.0001*q^3-1*0.002*qdot");
+        force->setName(tissue.first);
+        model.addForce(force);
+    }
+    auto controller = new FixationController();
+    controller->setName("fixation_controller");
+    controller->set_thetaH(15);
+    controller->set_thetaV(-15);
+    controller->set_kpH(50);
+    controller->set_kdH(1.5);
+    controller->set_kpV(50);
+    controller->set_kdV(1.5);
+    controller->set_kpT(100);
+    controller->set_kdT(0.5);
+    controller->set_saccade_onset(0.5);
+    controller->set_saccade_velocity(100);
+    model.addController(controller);
+    auto& state = model.initSystem();
+    model.equilibrateMuscles(state);
+    return simulate(model, state, 1);
+}
+
+// A constant drive component (see TestNeuron).
+class ConstantSource : public ModelComponent {
+    OpenSim_DECLARE_CONCRETE_OBJECT(ConstantSource, OpenSim::ModelComponent);
+
+ public:
+    OpenSim_DECLARE_PROPERTY(value, double, "Constant value.");
+    OpenSim_DECLARE_OUTPUT(output, double, getValue, SimTK::Stage::Time);
+
+    ConstantSource(double value) { constructProperty_value(value); }
+
+    double getValue(const SimTK::State& s) const { return get_value(); }
+};
+
+// The test of 06_model_component_neuron.
+Measurement neuron() {
+    Model model;
+    auto neuron = new Neuron();
+    neuron->set_C(200e-12);
+    neuron->set_R(100e6);
+    neuron->set_v_rest(-70e-3);
+    neuron->set_v_threshold(-60e-3);
+    model.addModelComponent(neuron);
+    auto constant = new ConstantSource(150e-12);
+    model.addModelComponent(constant);
+    neuron->connectInput_I(constant->getOutput("output"));
+    auto& state = model.initSystem();
+    return simulate(model, state, 0.5, 0.001);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// results
+
+const string csvHeader = "scenario,wall_time_s,steps,rejected_steps,"
+                         "realizations,peak_rss_kb";
+
+// Runs the repetitions of a scenario and returns the fastest.
+Measurement runScenario(const Scenario& scenario, int numRepetitions) {
+    Measurement best;
+    for (int k = 0; k < numRepetitions; k++) {
+        auto measurement = scenario();
+        if (k == 0 || measurement.wallTime < best.wallTime) best = measurement;
+    }
+    return best;
+}
+
+// Runs the repetitions of a scenario in this process and returns its CSV row.
+string runScenarioRow(const string& name, const Scenario& scenario,
+                      int numRepetitions) {
+    auto best = runScenario(scenario, numRepetitions);
+    ostringstream row;
+    row << name << "," << best.wallTime << "," << best.numSteps << ","
+        << best.numRejectedSteps << "," << best.numRealizations << ","
+        << getPeakRSS();
+    return row.str();
+}
+
+// Reads the measurement of a CSV row printed by this program.
+Measurement parseMeasurement(const string& line) {
+    istringstream row(line);
+    vector<string> fields;
+    string field;
+    while (getline(row, field, ',')) fields.push_back(field);
+    if (fields.size() < 5) throw Exception("invalid result " + line);
+    Measurement measurement;
+    measurement.wallTime = stod(fields[1]);
+    measurement.numSteps = stoi(fields[2]);
+    measurement.numRejectedSteps = stoi(fields[3]);
+    measurement.numRealizations = stoi(fields[4]);
+    return measurement;
+}
+
+// Path of the executable of this process or an empty string if unavailable
+// (argv[0] depends on the PATH and the working directory).
+string getExecutablePath() {
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD size = GetModuleFileNameA(NULL, path, MAX_PATH);
+    if (size == 0 || size == MAX_PATH) return "";
+    return string(path, size);
+#elif defined(__APPLE__)
+    char path[4096];
+    uint32_t size = sizeof(path);
+    if (_NSGetExecutablePath(path, &size) != 0) return "";
+    return path;
+#else
+    char path[4096];
+    ssize_t size = readlink("/proc/self/exe", path, sizeof(path));
+    if (size <= 0 || size == ssize_t(sizeof(path))) return "";
+    return string(path, size);
+#endif
+}
+
+// Quotes an argument of a command of the shell.
+string quote(const string& argument) {
+#ifdef _WIN32
+    return "\"" + argument + "\"";
+#else
+    string quoted = "'";
+    for (char c : argument) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+#endif
+}
+
+// Runs a scenario in a new process (see --scenario) and reads its CSV row.
+// Returns false if the process cannot be started.
+bool runScenarioProcess(const string& program, const string& name,
+                        int numRepetitions, string& row) {
+    string resultFile = "SimulationBenchmarks_" + name + ".csv";
+    remove(resultFile.c_str());
+    string command = quote(program) + " --scenario " + quote(name) +
+                     " --repeat " + to_string(numRepetitions) + " --output " +
+                     quote(resultFile);
+#ifdef _WIN32
+    // cmd /c removes the outer quotes of a command that starts with a quote
+    command = "\"" + command + "\"";
+#endif
+    int status = system(command.c_str());
+    if (status == -1) return false;
+#ifndef _WIN32
+    // the shell could not execute the program
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127) return false;
+#endif
+    if (status != 0) throw Exception("scenario " + name + " failed");
+    ifstream file(resultFile);
+    string header;
+    if (!getline(file, header) || !getline(file, row)) {
+        throw Exception("cannot read " + resultFile);
+    }
+    file.close();
+    remove(resultFile.c_str());
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// baseline
+
+// Reads the wall time of each scenario from a CSV file printed by this
+// program.
+map<string, double> readBaseline(const string& fileName) {
+    ifstream file(fileName);
+    if (!file) throw Exception("cannot read " + fileName);
+    map<string, double> baseline;
+    string line;
+    getline(file, line); // header
+    while (getline(file, line)) {
+        istringstream row(line);
+        string scenario, wallTime;
+        if (getline(row, scenario, ',') && getline(row, wallTime, ',')) {
+            baseline[scenario] = stod(wallTime);
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        int numRepetitions = 1;
+        string outputFile, baselineFile, scenarioName;
+        double tolerance = 0.1;
+        for (int i = 1; i < argc; i++) {
+            string argument = argv[i];
+            if (argument == "--repeat" && i + 1 < argc) {
+                numRepetitions = max(atoi(argv[++i]), 1);
+            } else if (argument == "--output" && i + 1 < argc) {
+                outputFile = argv[++i];
+            } else if (argument == "--baseline" && i + 1 < argc) {
+                baselineFile = argv[++i];
+            } else if (argument == "--tolerance" && i + 1 < argc) {
+                tolerance = stod(argv[++i]);
+            } else if (argument == "--scenario" && i + 1 < argc) {
+                scenarioName = argv[++i];
+            } else {
+                throw Exception("unknown argument " + argument);
+            }
+        }
+
+        const vector<pair<string, Scenario>> scenarios = {
+                {"dennis_init_system", dennisInitSystem},
+                {"dennis_equilibrate_muscles", dennisEquilibrateMuscles},
+                {"dennis_restore_snapshot", dennisRestoreSnapshot},
+                {"dennis_hop_1s", []() { return dennisHop(1); }},
+                {"dennis_hop_5s", []() { return dennisHop(5); }},
+                {"dennis_hop_5s_switching_events",
+                 []() { return dennisHop(5, true); }},
+                {"high_jump_evaluation", highJumpEvaluation},
+                {"tug_of_war_perturbation_1s", tugOfWarPerturbation},
+                {"perturbation_compute_force_1_body",
+                 []() {
+                     return perturbationComputeForce<PerturbationForce>(1);
+                 }},
+                {"perturbation_compute_force_10_bodies",
+                 []() {
+                     return perturbationComputeForce<PerturbationForce>(10);
+                 }},
+                {"perturbation_compute_force_100_bodies",
+                 []() {
+                     return perturbationComputeForce<PerturbationForce>(100);
+                 }},
+                {"perturbation_set_compute_force_100_bodies",
+                 []() {
+                     return perturbationComputeForce<PerturbationForceSet>(
+                             100);
+                 }},
+                {"eye_saccade_1s", eyeSaccade},
+                {"neuron_0.5s", neuron}};
+
+        stringstream csv;
+        csv << csvHeader << "\n";
+        // A single scenario in this process, as run by the loop below.
+        if (!scenarioName.empty()) {
+            auto scenario = find_if(
+                    scenarios.begin(), scenarios.end(),
+                    [&](const pair<string, Scenario>& candidate) {
+                        return candidate.first == scenarioName;
+                    });
+            if (scenario == scenarios.end()) {
+                throw Exception("unknown scenario " + scenarioName);
+            }
+            csv << runScenarioRow(scenarioName, scenario->second,
+                                  numRepetitions)
+                << "\n";
+            if (outputFile.empty()) {
+                cout << csv.str();
+                return 0;
+            }
+            ofstream file(outputFile);
+            if (!file) throw Exception("cannot write " + outputFile);
+            file << csv.str();
+            return 0;
+        }
+
+        map<string, Measurement> measurements;
+        string program = getExecutablePath();
+        bool inProcess = program.empty() || system(NULL) == 0;
+        bool noted = false;
+        for (const auto& scenario : scenarios) {
+            string row;
+            if (!inProcess) {
+                inProcess = !runScenarioProcess(program, scenario.first,
+                                                numRepetitions, row);
+            }
+            if (inProcess) {
+                if (!noted) {
+                    cout << "note: cannot start a process of this program, "
+                            "the peak RSS of a scenario includes the "
+                            "previous scenarios"
+                         << endl;
+                    noted = true;
+                }
+                row = runScenarioRow(scenario.first, scenario.second,
+                                     numRepetitions);
+            }
+            measurements[scenario.first] = parseMeasurement(row);
+            csv << row << "\n";
+        }
+        cout << csv.str();
+        if (!outputFile.empty()) {
+            ofstream file(outputFile);
+            if (!file) throw Exception("cannot write " + outputFile);
+            file << csv.str();
+        }
+        const auto& withoutEvents = measurements["dennis_hop_5s"];
+        const auto& withEvents = measurements["dennis_hop_5s_switching_events"];
+        cout << "switching events saved "
+             << withoutEvents.numRealizations - withEvents.numRealizations
+             << " realizations and "
+             << withoutEvents.numRejectedSteps - withEvents.numRejectedSteps
+             << " rejected steps of dennis_hop_5s" << endl;
+        for (int n : {1, 10, 100}) {
+            string name = "perturbation_compute_force_" + to_string(n) +
+                          (n == 1 ? "_body" : "_bodies");
+            cout << name << ": "
+                 << 1e9 * measurements[name].wallTime / numForceEvaluations
+                 << " ns per call" << endl;
+        }
+
+        if (baselineFile.empty()) return 0;
+        int numRegressions = 0;
+        for (const auto& baseline : readBaseline(baselineFile)) {
+            if (!measurements.count(baseline.first)) continue;
+            double change =
+                    measurements[baseline.first].wallTime / baseline.second - 1;
+            if (change > tolerance) {
+                cout << "REGRESSION " << baseline.first << ": "
+                     << 100 * change << "% slower than the baseline" << endl;
+                numRegressions++;
+            }
+        }
+        cout << numRegressions << " regression(s)" << endl;
+        return numRegressions > 0 ? 1 : 0;
+    } catch (exception& e) {
+        cout << typeid(e).name() << ": " << e.what() << endl;
+        return -1;
+    }
+}
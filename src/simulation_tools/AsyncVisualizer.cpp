@@ -0,0 +1,150 @@
+#include "AsyncVisualizer.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <simbody/internal/Visualizer.h>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+namespace {
+// Generates the geometry of the OpenSim components (e.g., meshes and paths),
+// as the visualizer of the model does.
+class ModelDecorations : public DecorationGenerator {
+ public:
+    ModelDecorations(const Model& model) : model(model) {}
+    void generateDecorations(const State& s,
+                             Array_<DecorativeGeometry>& geometry) override {
+        const auto& hints = model.getDisplayHints();
+        model.generateDecorations(true, hints, s, geometry);
+        model.generateDecorations(false, hints, s, geometry);
+    }
+
+ private:
+    const Model& model;
+};
+} // namespace
+
+VisualizerPublisher::VisualizerPublisher() : Analysis() {}
+
+VisualizerPublisher::VisualizerPublisher(
+        const std::shared_ptr<LatestValue<StateSnapshot>>& slot)
+        : Analysis(), slot(slot) {
+    setName("VisualizerPublisher");
+}
+
+void VisualizerPublisher::publish(const State& s) {
+    if (!slot) return;
+    auto& snapshot = slot->back();
+    snapshot.time = s.getTime();
+    snapshot.y = s.getY();
+    slot->publish();
+}
+
+int VisualizerPublisher::begin(const State& s) {
+    publish(s);
+    return 0;
+}
+
+int VisualizerPublisher::step(const State& s, int stepNumber) {
+    publish(s);
+    return 0;
+}
+
+int VisualizerPublisher::end(const State& s) {
+    publish(s);
+    return 0;
+}
+
+AsyncVisualizer::AsyncVisualizer(Model& model, double maxFrameRate)
+        : model(model), maxFrameRate(maxFrameRate),
+          slot(std::make_shared<LatestValue<StateSnapshot>>()),
+          running(false), numFrames(0) {
+    if (!(maxFrameRate > 0)) {
+        throw Exception("AsyncVisualizer: frame rate must be positive");
+    }
+    model.addAnalysis(new VisualizerPublisher(slot));
+}
+
+AsyncVisualizer::~AsyncVisualizer() { stop(); }
+
+void AsyncVisualizer::start(const State& s, const Configuration& configure) {
+    if (renderThread.joinable()) {
+        throw Exception("AsyncVisualizer: already started");
+    }
+    // The simulation has not started yet, thus, the model can be copied.
+    renderModel.reset(model.clone());
+    renderModel->setUseVisualizer(false);
+    showDefaultGeometry = model.getMatterSubsystem().getShowDefaultGeometry();
+    initialState.time = s.getTime();
+    initialState.y = s.getY();
+    this->configure = configure;
+    running = true;
+    renderThread = std::thread(&AsyncVisualizer::run, this);
+}
+
+void AsyncVisualizer::stop() {
+    if (!renderThread.joinable()) return;
+    running = false;
+    renderThread.join();
+}
+
+void AsyncVisualizer::run() {
+    const auto period = std::chrono::duration_cast<
+            std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1 / maxFrameRate));
+    try {
+        renderState = renderModel->initSystem();
+        renderModel->updMatterSubsystem().setShowDefaultGeometry(
+                showDefaultGeometry);
+        visualizer.reset(new Visualizer(renderModel->getMultibodySystem()));
+        visualizer->setShutdownWhenDestructed(true);
+        visualizer->setDesiredFrameRate(maxFrameRate);
+        // The visualizer takes ownership of the generator.
+        visualizer->addDecorationGenerator(new ModelDecorations(*renderModel));
+        if (configure) configure(*visualizer);
+
+        // The initial state is drawn before any state is published.
+        renderState.setTime(initialState.time);
+        renderState.updY() = initialState.y;
+        renderModel->getMultibodySystem().realize(renderState,
+                                                  Stage::Position);
+        visualizer->drawFrameNow(renderState);
+        numFrames++;
+        auto next = std::chrono::steady_clock::now();
+        while (running) {
+            next = std::max(next + period, std::chrono::steady_clock::now());
+            std::this_thread::sleep_until(next);
+            draw();
+        }
+        // The final state of the simulation.
+        draw();
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+}
+
+void AsyncVisualizer::draw() {
+    if (!slot->update()) return;
+    const auto& snapshot = slot->front();
+    renderState.setTime(snapshot.time);
+    renderState.updY() = snapshot.y;
+    renderModel->getMultibodySystem().realize(renderState, Stage::Position);
+    visualizer->drawFrameNow(renderState);
+    numFrames++;
+}
+
+VisualizationMode OpenSim::getVisualizationMode(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            return VisualizationMode::Headless;
+        }
+        if (strcmp(argv[i], "--async-visualizer") == 0) {
+            return VisualizationMode::Async;
+        }
+    }
+    return VisualizationMode::Inline;
+}
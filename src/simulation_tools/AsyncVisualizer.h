@@ -0,0 +1,133 @@
+/**
+ * @file AsyncVisualizer.h
+ *
+ * \brief Visualizes a simulation on a separate thread at a capped frame rate,
+ * without slowing down the integration.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef ASYNC_VISUALIZER_H
+#define ASYNC_VISUALIZER_H
+
+#include "LatestValue.h"
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Simulation/Model/Analysis.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace SimTK {
+class Visualizer;
+}
+
+namespace OpenSim {
+/** A state of the simulation that is passed to the render thread. */
+struct StateSnapshot {
+    double time = SimTK::NaN;
+    SimTK::Vector y;
+};
+
+/**
+ * \brief An analysis that publishes the state of each accepted step to an
+ * AsyncVisualizer.
+ *
+ * Publishing copies the continuous state variables into a lock-free slot,
+ * therefore, the integration is never blocked by rendering.
+ */
+class SimulationTools_API VisualizerPublisher : public Analysis {
+    OpenSim_DECLARE_CONCRETE_OBJECT(VisualizerPublisher, Analysis);
+
+ public:
+    VisualizerPublisher();
+    explicit VisualizerPublisher(
+            const std::shared_ptr<LatestValue<StateSnapshot>>& slot);
+
+    int begin(const SimTK::State& s) override;
+    int step(const SimTK::State& s, int stepNumber) override;
+    int end(const SimTK::State& s) override;
+
+ private:
+    void publish(const SimTK::State& s);
+
+    // Shared with the visualizer, so that either can be destroyed first.
+    std::shared_ptr<LatestValue<StateSnapshot>> slot;
+};
+
+/**
+ * \brief Draws the latest published state of a model on a render thread.
+ *
+ * Usage: construct the visualizer before Model::initSystem (it adds a
+ * VisualizerPublisher to the model), keep model.setUseVisualizer(false) so
+ * that no frames are drawn on the simulation thread, and call start() after
+ * initSystem. The render thread draws at most maxFrameRate frames per second
+ * and skips the states that are published in between.
+ *
+ * OpenSim components are not thread-safe, thus, the render thread draws a
+ * copy of the model, which is cloned by start() and initialized on the render
+ * thread. The published state variables are copied into the state of that
+ * copy, which is realized to Stage::Position (enough to place the geometry).
+ * The model must not be modified between its construction and start().
+ */
+class SimulationTools_API AsyncVisualizer {
+ public:
+    typedef std::function<void(SimTK::Visualizer&)> Configuration;
+
+    AsyncVisualizer(Model& model, double maxFrameRate = 30);
+    /** Stops the render thread. */
+    ~AsyncVisualizer();
+    AsyncVisualizer(const AsyncVisualizer&) = delete;
+    AsyncVisualizer& operator=(const AsyncVisualizer&) = delete;
+
+    /** Copies the model and starts the render thread, which initializes the
+     * copy, creates the visualizer, applies the configuration (e.g.,
+     * background color) and draws the given state until a new one is
+     * published. */
+    void start(const SimTK::State& s,
+               const Configuration& configure = Configuration());
+    /** Draws the latest state and stops the render thread. */
+    void stop();
+
+    /** Number of drawn frames. */
+    int getNumFrames() const { return numFrames; }
+    /** Error of the render thread that stopped the drawing, if any. */
+    const std::string& getError() const { return error; }
+
+ private:
+    void run();
+    void draw();
+
+    const Model& model;
+    double maxFrameRate;
+    std::shared_ptr<LatestValue<StateSnapshot>> slot;
+    // Used only by the render thread.
+    std::unique_ptr<Model> renderModel;
+    std::unique_ptr<SimTK::Visualizer> visualizer;
+    SimTK::State renderState;
+    StateSnapshot initialState;
+    bool showDefaultGeometry = false;
+    Configuration configure;
+    std::atomic<bool> running;
+    std::atomic<int> numFrames;
+    std::string error;
+    std::thread renderThread;
+};
+
+/** How a simulation is visualized. */
+enum class VisualizationMode {
+    /** By the visualizer of the model, on the simulation thread. */
+    Inline,
+    /** By an AsyncVisualizer, on a render thread. */
+    Async,
+    /** Not at all (e.g., for batch runs). */
+    Headless
+};
+/** Parses --async-visualizer and --headless from the command line (Inline
+ * otherwise). */
+SimulationTools_API VisualizationMode getVisualizationMode(int argc,
+                                                           char* argv[]);
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,71 @@
+#include "AsyncWriter.h"
+
+#include <exception>
+#include <iostream>
+
+using namespace OpenSim;
+
+AsyncWriter::AsyncWriter() : thread(&AsyncWriter::run, this) {}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    hasWork.notify_one();
+    thread.join();
+}
+
+void AsyncWriter::submit(const std::string& key, const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(key);
+        if (it != pending.end()) {
+            it->second = task;
+            numCoalesced++;
+        } else {
+            pending[key] = task;
+        }
+    }
+    hasWork.notify_one();
+}
+
+void AsyncWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    isIdle.wait(lock, [this] { return pending.empty() && !busy; });
+}
+
+int AsyncWriter::getNumWritten() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numWritten;
+}
+
+int AsyncWriter::getNumCoalesced() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numCoalesced;
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        hasWork.wait(lock, [this] { return stop || !pending.empty(); });
+        // Pending tasks are written before stopping.
+        if (pending.empty()) break;
+        auto tasks = std::move(pending);
+        pending.clear();
+        busy = true;
+        lock.unlock();
+        for (auto& task : tasks) {
+            try {
+                task.second();
+            } catch (const std::exception& e) {
+                std::cerr << "AsyncWriter: " << task.first << ": " << e.what()
+                          << std::endl;
+            }
+        }
+        lock.lock();
+        numWritten += (int) tasks.size();
+        busy = false;
+        isIdle.notify_all();
+    }
+}
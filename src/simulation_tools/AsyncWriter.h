@@ -0,0 +1,64 @@
+/**
+ * @file AsyncWriter.h
+ *
+ * \brief Executes output tasks on a background thread.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include "SimulationToolsExports.h"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace OpenSim {
+/**
+ * \brief A background writer that coalesces bursts of output tasks.
+ *
+ * Tasks are submitted with a key. If a task with the same key is still
+ * pending, it is replaced by the new one, therefore, only the latest snapshot
+ * is written when improvements arrive faster than they can be written. Tasks
+ * must own the data that they write, because they are executed after submit()
+ * returns. The destructor writes all pending tasks before joining the thread.
+ */
+class SimulationTools_API AsyncWriter {
+ public:
+    typedef std::function<void()> Task;
+
+    AsyncWriter();
+    ~AsyncWriter();
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    /** Schedules a task, replacing any pending task with the same key. */
+    void submit(const std::string& key, const Task& task);
+    /** Blocks until all submitted tasks have been executed. */
+    void flush();
+
+    /** Number of executed tasks. */
+    int getNumWritten() const;
+    /** Number of tasks that were replaced before being executed. */
+    int getNumCoalesced() const;
+
+ private:
+    void run();
+
+    std::map<std::string, Task> pending;
+    bool busy = false;
+    bool stop = false;
+    int numWritten = 0;
+    int numCoalesced = 0;
+    mutable std::mutex mutex;
+    std::condition_variable hasWork;
+    std::condition_variable isIdle;
+    std::thread thread;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,278 @@
+#include "BinaryStorage.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <OpenSim/Common/IO.h>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace OpenSim;
+using namespace std;
+
+namespace {
+const char magic[4] = {'O', 'S', 'B', 'S'};
+const uint32_t version = 1;
+
+template <typename T> void writeValue(ostream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(ostream& file, const string& value) {
+    writeValue(file, uint32_t(value.size()));
+    file.write(value.data(), value.size());
+}
+
+// Reads the header from a contiguous block of memory.
+class HeaderReader {
+ public:
+    HeaderReader(const char* begin, size_t size, const string& fileName)
+            : begin(begin), size(size), fileName(fileName) {}
+    template <typename T> T readValue() {
+        T value;
+        memcpy(&value, next(sizeof(T)), sizeof(T));
+        return value;
+    }
+    string readString() {
+        auto length = readValue<uint32_t>();
+        return string(next(length), length);
+    }
+    size_t getOffset() const { return offset; }
+
+ private:
+    const char* next(size_t length) {
+        if (length > size - offset) {
+            throw Exception("BinaryStorage: " + fileName + " is truncated");
+        }
+        const char* current = begin + offset;
+        offset += length;
+        return current;
+    }
+    const char* begin;
+    size_t size;
+    size_t offset = 0;
+    const string& fileName;
+};
+} // namespace
+
+BinaryStorage::BinaryStorage(const string& fileName, bool memoryMap) {
+    const char* begin = nullptr;
+    size_t size = 0;
+#ifndef _WIN32
+    if (memoryMap) {
+        int descriptor = open(fileName.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw Exception("BinaryStorage: cannot read " + fileName);
+        }
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+            mappingSize = size_t(status.st_size);
+            mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE,
+                           descriptor, 0);
+            if (mapping == MAP_FAILED) mapping = nullptr;
+        }
+        close(descriptor);
+        if (mapping) {
+            begin = static_cast<const char*>(mapping);
+            size = mappingSize;
+        }
+    }
+#endif
+    if (!begin) {
+        ifstream file(fileName, ios::binary | ios::ate);
+        if (!file) throw Exception("BinaryStorage: cannot read " + fileName);
+        buffer.resize(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+        begin = buffer.data();
+        size = buffer.size();
+    }
+
+    try {
+        HeaderReader reader(begin, size, fileName);
+        char fileMagic[4];
+        for (auto& c : fileMagic) c = reader.readValue<char>();
+        if (memcmp(fileMagic, magic, sizeof(magic)) != 0) {
+            throw Exception("BinaryStorage: " + fileName +
+                            " is not a binary storage file");
+        }
+        if (reader.readValue<uint32_t>() != version) {
+            throw Exception("BinaryStorage: " + fileName +
+                            " has an unsupported version or byte order");
+        }
+        numRows = reader.readValue<uint64_t>();
+        numColumns = reader.readValue<uint64_t>();
+        inDegrees = reader.readValue<uint8_t>() != 0;
+        name = reader.readString();
+        for (uint64_t j = 0; j < numColumns; ++j) {
+            labels.push_back(reader.readString());
+            units.push_back(reader.readString());
+        }
+        size_t offset = (reader.getOffset() + 7) / 8 * 8;
+        if (offset > size ||
+            (size - offset) / sizeof(double) / max(numColumns, uint64_t(1)) <
+                    numRows) {
+            throw Exception("BinaryStorage: " + fileName + " is truncated");
+        }
+        // The offset is aligned and both mmap and vector<char> return memory
+        // that is aligned for double.
+        data = reinterpret_cast<const double*>(begin + offset);
+    } catch (...) {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, mappingSize);
+#endif
+        throw;
+    }
+}
+
+BinaryStorage::~BinaryStorage() {
+#ifndef _WIN32
+    if (mapping) munmap(mapping, mappingSize);
+#endif
+}
+
+int BinaryStorage::getColumnIndex(const string& label) const {
+    for (int j = 0; j < int(labels.size()); ++j) {
+        if (labels[j] == label) return j;
+    }
+    return -1;
+}
+
+const double* BinaryStorage::getColumn(int index) const {
+    if (index < 0 || index >= int(numColumns)) {
+        throw Exception("BinaryStorage: column index " + to_string(index) +
+                        " is out of range");
+    }
+    return data + size_t(index) * numRows;
+}
+
+const double* BinaryStorage::getColumn(const string& label) const {
+    int index = getColumnIndex(label);
+    if (index < 0) throw Exception("BinaryStorage: no column " + label);
+    return getColumn(index);
+}
+
+void BinaryStorage::toStorage(Storage& storage) const {
+    storage.reset(0);
+    storage.setName(name);
+    storage.setInDegrees(inDegrees);
+    Array<string> columnLabels;
+    for (const auto& label : labels) columnLabels.append(label);
+    storage.setColumnLabels(columnLabels);
+    if (numColumns == 0) return;
+    vector<double> row(numColumns - 1);
+    for (uint64_t i = 0; i < numRows; ++i) {
+        for (uint64_t j = 1; j < numColumns; ++j) {
+            row[j - 1] = data[j * numRows + i];
+        }
+        storage.append(data[i], int(row.size()), row.data(), false);
+    }
+}
+
+void BinaryStorage::write(const Storage& storage, const string& fileName,
+                          const vector<string>& units) {
+    const auto& columnLabels = storage.getColumnLabels();
+    uint64_t numColumns = columnLabels.getSize();
+    uint64_t numRows = storage.getSize();
+    if (numColumns == 0) {
+        throw Exception("BinaryStorage: " + storage.getName() +
+                        " has no column labels");
+    }
+    vector<string> labels;
+    for (uint64_t j = 0; j < numColumns; ++j) {
+        labels.push_back(columnLabels[int(j)]);
+    }
+
+    // Transpose the rows into columns; short rows are padded with NaN.
+    vector<double> columns(numColumns * numRows,
+                           numeric_limits<double>::quiet_NaN());
+    for (uint64_t i = 0; i < numRows; ++i) {
+        auto row = storage.getStateVector(int(i));
+        columns[i] = row->getTime();
+        const auto& values = row->getData();
+        uint64_t size = min(uint64_t(values.getSize()), numColumns - 1);
+        for (uint64_t j = 0; j < size; ++j) {
+            columns[(j + 1) * numRows + i] = values[int(j)];
+        }
+    }
+
+    ofstream file(fileName, ios::binary);
+    if (!file) throw Exception("BinaryStorage: cannot write " + fileName);
+    writeHeader(file, storage.getName(), storage.isInDegrees(), numRows,
+                labels, units);
+    file.write(reinterpret_cast<const char*>(columns.data()),
+               columns.size() * sizeof(double));
+    if (!file) throw Exception("BinaryStorage: cannot write " + fileName);
+}
+
+void BinaryStorage::write(const TimeSeriesTable& table, const string& name,
+                          const string& fileName) {
+    uint64_t numRows = table.getNumRows();
+    vector<string> labels{"time"};
+    for (const auto& label : table.getColumnLabels()) labels.push_back(label);
+    bool inDegrees = table.hasTableMetaDataKey("inDegrees") &&
+                     table.getTableMetaData<string>("inDegrees") == "yes";
+
+    ofstream file(fileName, ios::binary);
+    if (!file) throw Exception("BinaryStorage: cannot write " + fileName);
+    writeHeader(file, name, inDegrees, numRows, labels);
+    // The columns of the table are already contiguous.
+    const auto& time = table.getIndependentColumn();
+    file.write(reinterpret_cast<const char*>(time.data()),
+               numRows * sizeof(double));
+    for (size_t j = 0; j < table.getNumColumns(); ++j) {
+        auto column = table.getDependentColumnAtIndex(j);
+        for (uint64_t i = 0; i < numRows; ++i) writeValue(file, column[int(i)]);
+    }
+    if (!file) throw Exception("BinaryStorage: cannot write " + fileName);
+}
+
+void BinaryStorage::writeHeader(ostream& file, const string& name,
+                                bool inDegrees, uint64_t numRows,
+                                const vector<string>& labels,
+                                const vector<string>& units) {
+    uint64_t numColumns = labels.size();
+    if (!units.empty() && units.size() != numColumns - 1) {
+        throw Exception("BinaryStorage: expected " +
+                        to_string(numColumns - 1) + " units");
+    }
+    file.write(magic, sizeof(magic));
+    writeValue(file, version);
+    writeValue(file, numRows);
+    writeValue(file, numColumns);
+    writeValue(file, uint8_t(inDegrees));
+    writeString(file, name);
+    for (uint64_t j = 0; j < numColumns; ++j) {
+        writeString(file, labels[j]);
+        writeString(file, j == 0 ? "s" : units.empty() ? "" : units[j - 1]);
+    }
+    // The columns start at a multiple of 8 bytes (see the constructor).
+    auto headerSize = uint64_t(file.tellp());
+    for (uint64_t k = headerSize; k % 8 != 0; ++k) file.put(0);
+}
+
+void BinaryStorage::convertFromSto(const string& stoFile,
+                                   const string& binaryFile) {
+    Storage storage(stoFile);
+    write(storage, binaryFile);
+}
+
+void BinaryStorage::convertToSto(const string& binaryFile,
+                                 const string& stoFile) {
+    Storage storage;
+    BinaryStorage(binaryFile).toStorage(storage);
+    // 17 significant digits restore a double exactly.
+    bool gFormat = IO::GetGFormatForDoubleOutput();
+    int precision = IO::GetPrecision();
+    IO::SetGFormatForDoubleOutput(true);
+    IO::SetPrecision(numeric_limits<double>::max_digits10);
+    storage.print(stoFile);
+    IO::SetGFormatForDoubleOutput(gFormat);
+    IO::SetPrecision(precision);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file BinaryStorage.h
+ *
+ * \brief A binary columnar file format for time series and its conversion to
+ * and from Storage.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef BINARY_STORAGE_H
+#define BINARY_STORAGE_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Common/TimeSeriesTable.h>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Reads a binary storage file (.osb).
+ *
+ * The file consists of a header followed by the columns (time being the first
+ * column), each stored as a contiguous array of float64 values:
+ *
+ * - magic "OSBS" and format version (uint32)
+ * - number of rows and columns (uint64)
+ * - inDegrees flag (uint8) and the name of the storage
+ * - the label and the unit of each column
+ * - padding up to a multiple of 8 bytes
+ * - the columns
+ *
+ * Strings are stored as a length (uint32) followed by the characters. Numbers
+ * are stored in the byte order of the machine that wrote the file; a file of
+ * the other byte order is rejected. Missing values are NaN.
+ *
+ * The columns are accessed in place: if the file is memory-mapped they are
+ * not copied, otherwise the file is read at once.
+ */
+class SimulationTools_API BinaryStorage {
+ public:
+    /** Opens a file. If memoryMap is false (or memory mapping is not
+     * supported) the file is read into memory. */
+    BinaryStorage(const std::string& fileName, bool memoryMap = true);
+    ~BinaryStorage();
+    BinaryStorage(const BinaryStorage&) = delete;
+    BinaryStorage& operator=(const BinaryStorage&) = delete;
+
+    const std::string& getName() const { return name; }
+    bool isInDegrees() const { return inDegrees; }
+    int getNumRows() const { return int(numRows); }
+    int getNumColumns() const { return int(numColumns); }
+    /** The labels of the columns, the first being "time". */
+    const std::vector<std::string>& getColumnLabels() const { return labels; }
+    const std::vector<std::string>& getUnits() const { return units; }
+    /** Index of the column with the given label or -1. */
+    int getColumnIndex(const std::string& label) const;
+    /** Contiguous values of a column (getNumRows() values). */
+    const double* getColumn(int index) const;
+    const double* getColumn(const std::string& label) const;
+    bool isMemoryMapped() const { return mapping != nullptr; }
+
+    /** Copies the file into a Storage. */
+    void toStorage(Storage& storage) const;
+
+    /** Writes a storage to a binary file. The units (if given) correspond to
+     * the data columns, i.e., excluding time. */
+    static void write(const Storage& storage, const std::string& fileName,
+                      const std::vector<std::string>& units = {});
+    /** Writes a table (e.g., Model::getControlsTable()) to a binary file. */
+    static void write(const TimeSeriesTable& table, const std::string& name,
+                      const std::string& fileName);
+    /** Writes the header, including the padding, for writers that produce
+     * the columns themselves (e.g., StreamingStorageWriter). The labels
+     * include time and the units (if given) correspond to the data
+     * columns. */
+    static void writeHeader(std::ostream& file, const std::string& name,
+                            bool inDegrees, std::uint64_t numRows,
+                            const std::vector<std::string>& labels,
+                            const std::vector<std::string>& units = {});
+    /** Converts a .sto file to a binary file. */
+    static void convertFromSto(const std::string& stoFile,
+                               const std::string& binaryFile);
+    /** Converts a binary file to a .sto file. The values are printed with
+     * enough digits to be restored exactly. */
+    static void convertToSto(const std::string& binaryFile,
+                             const std::string& stoFile);
+
+ private:
+    std::string name;
+    bool inDegrees = false;
+    std::uint64_t numRows = 0, numColumns = 0;
+    std::vector<std::string> labels, units;
+    // Either the memory-mapped file or the buffer holds the file.
+    void* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    std::vector<char> buffer;
+    const double* data = nullptr;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file ControlBasis.h
+ *
+ * \brief Smooth parametrizations of a control signal on a uniform grid (uniform
+ * B-splines and piecewise Bezier curves) with a compile-time degree.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef CONTROL_BASIS_H
+#define CONTROL_BASIS_H
+
+#include <algorithm>
+
+namespace OpenSim {
+namespace detail {
+// Locates the segment of t on a uniform grid of m segments over [t0, t1] in
+// constant time. Times outside the interval are clamped to the ends.
+inline int locateSegment(int m, double t0, double t1, double t, double& h,
+                         double& s) {
+    h = (t1 - t0) / m;
+    double u = std::min(std::max((t - t0) / h, 0.0), double(m));
+    int i = std::min(int(u), m - 1);
+    s = u - i;
+    return i;
+}
+} // namespace detail
+
+/**
+ * \brief Uniform B-spline of the given degree with n coefficients over [t0,
+ * t1], which is divided into n - Degree segments.
+ *
+ * The spline is Degree - 1 times continuously differentiable and each segment
+ * depends on Degree + 1 coefficients. The value lies within the range of the
+ * coefficients (convex hull property), therefore, bounds on the coefficients
+ * are bounds on the control.
+ */
+template <int Degree> struct UniformBSpline {
+    static_assert(Degree >= 1, "UniformBSpline: degree must be positive");
+
+    static int getNumSegments(int n) { return n - Degree; }
+    static int getNumCoefficients(int numSegments) {
+        return numSegments + Degree;
+    }
+
+    /** Value (order 0) or derivative of the spline at t. Requires n >
+     * Degree. The value is constant outside [t0, t1]. */
+    static double evaluate(const double* c, int n, double t0, double t1,
+                           double t, int order) {
+        if (order > Degree || (order > 0 && (t < t0 || t > t1))) return 0;
+        double h, s;
+        int i = detail::locateSegment(n - Degree, t0, t1, t, h, s);
+        double d[Degree + 1];
+        for (int k = 0; k <= Degree; k++) d[k] = c[i + k];
+        // The derivative is a spline of lower degree of the differences.
+        for (int r = 0; r < order; r++) {
+            for (int k = 0; k < Degree - r; k++) d[k] = (d[k + 1] - d[k]) / h;
+        }
+        // de Boor's algorithm on the integer knots of the segment
+        int p = Degree - order;
+        for (int r = 1; r <= p; r++) {
+            for (int j = p; j >= r; j--) {
+                double alpha = (s + p - j) / (p + 1 - r);
+                d[j] = (1 - alpha) * d[j - 1] + alpha * d[j];
+            }
+        }
+        return d[p];
+    }
+};
+
+/**
+ * \brief Piecewise Bezier curve of the given degree with n coefficients over
+ * [t0, t1], which is divided into (n - 1) / Degree segments that share their
+ * end coefficients.
+ *
+ * The curve is continuous and passes through the first and the last
+ * coefficient of each segment; with a single segment (n = Degree + 1) it is a
+ * polynomial in the Bernstein basis. As for UniformBSpline, the value lies
+ * within the range of the coefficients.
+ */
+template <int Degree> struct PiecewiseBezier {
+    static_assert(Degree >= 1, "PiecewiseBezier: degree must be positive");
+
+    static int getNumSegments(int n) { return (n - 1) / Degree; }
+    static int getNumCoefficients(int numSegments) {
+        return numSegments * Degree + 1;
+    }
+
+    /** Value (order 0) or derivative of the curve at t. Requires n - 1 to be
+     * a positive multiple of Degree. The value is constant outside [t0,
+     * t1]. */
+    static double evaluate(const double* c, int n, double t0, double t1,
+                           double t, int order) {
+        if (order > Degree || (order > 0 && (t < t0 || t > t1))) return 0;
+        double h, s;
+        int i = detail::locateSegment((n - 1) / Degree, t0, t1, t, h, s);
+        double d[Degree + 1];
+        for (int k = 0; k <= Degree; k++) d[k] = c[i * Degree + k];
+        // The derivative is a curve of lower degree of the differences.
+        for (int r = 0; r < order; r++) {
+            for (int k = 0; k < Degree - r; k++) {
+                d[k] = (Degree - r) * (d[k + 1] - d[k]) / h;
+            }
+        }
+        // de Casteljau's algorithm
+        int p = Degree - order;
+        for (int r = 1; r <= p; r++) {
+            for (int k = 0; k <= p - r; k++) {
+                d[k] = (1 - s) * d[k] + s * d[k + 1];
+            }
+        }
+        return d[0];
+    }
+};
+} // namespace OpenSim
+
+#endif
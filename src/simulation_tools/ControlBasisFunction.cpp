@@ -0,0 +1,160 @@
+#include "ControlBasisFunction.h"
+#include "ControlBasis.h"
+
+#include <OpenSim/Common/Exception.h>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+namespace {
+const int maxDegree = 5;
+
+template <template <int> class Basis>
+ControlBasisFunction::Evaluator selectEvaluator(int degree) {
+    switch (degree) {
+    case 1:
+        return &Basis<1>::evaluate;
+    case 2:
+        return &Basis<2>::evaluate;
+    case 3:
+        return &Basis<3>::evaluate;
+    case 4:
+        return &Basis<4>::evaluate;
+    case 5:
+        return &Basis<5>::evaluate;
+    default:
+        return nullptr;
+    }
+}
+
+// A copy of the function for SimTK (e.g., for the function-based
+// components).
+class BasisFunction : public SimTK::Function {
+ public:
+    BasisFunction(ControlBasisFunction::Evaluator evaluator,
+                  const Vector& coefficients, double t0, double t1)
+            : evaluator(evaluator), coefficients(coefficients), t0(t0),
+              t1(t1) {}
+    Real calcValue(const Vector& x) const override {
+        return evaluator(&coefficients[0], coefficients.size(), t0, t1, x[0],
+                         0);
+    }
+    Real calcDerivative(const Array_<int>& derivComponents,
+                        const Vector& x) const override {
+        return evaluator(&coefficients[0], coefficients.size(), t0, t1, x[0],
+                         int(derivComponents.size()));
+    }
+    int getArgumentSize() const override { return 1; }
+    int getMaxDerivativeOrder() const override { return maxDegree + 1; }
+
+ private:
+    ControlBasisFunction::Evaluator evaluator;
+    Vector coefficients;
+    double t0, t1;
+};
+} // namespace
+
+ControlBasisFunction::ControlBasisFunction() : Function() {
+    constructProperties();
+}
+
+ControlBasisFunction::ControlBasisFunction(const std::string& basis,
+                                           int degree, double startTime,
+                                           double endTime,
+                                           const Vector& coefficients)
+        : Function() {
+    constructProperties();
+    set_basis(basis);
+    set_degree(degree);
+    set_start_time(startTime);
+    set_end_time(endTime);
+    setCoefficients(coefficients);
+}
+
+void ControlBasisFunction::constructProperties() {
+    constructProperty_basis("bspline");
+    constructProperty_degree(3);
+    constructProperty_start_time(0);
+    constructProperty_end_time(1);
+    constructProperty_coefficients();
+}
+
+void ControlBasisFunction::setCoefficients(const Vector& coefficients) {
+    if (getProperty_coefficients().size() != coefficients.size()) {
+        updProperty_coefficients().clear();
+        for (int i = 0; i < coefficients.size(); i++) {
+            append_coefficients(coefficients[i]);
+        }
+    } else {
+        for (int i = 0; i < coefficients.size(); i++) {
+            upd_coefficients(i) = coefficients[i];
+        }
+    }
+    applyProperties();
+}
+
+int ControlBasisFunction::getNumCoefficients(const std::string& basis,
+                                             int degree, int numSegments) {
+    if (basis == "bspline") return numSegments + degree;
+    if (basis == "bezier") return numSegments * degree + 1;
+    throw Exception("ControlBasisFunction: unknown basis " + basis);
+}
+
+void ControlBasisFunction::applyProperties() {
+    const auto& basis = get_basis();
+    int degree = get_degree();
+    if (basis == "bspline") {
+        evaluator = selectEvaluator<UniformBSpline>(degree);
+    } else if (basis == "bezier") {
+        evaluator = selectEvaluator<PiecewiseBezier>(degree);
+    } else {
+        throw Exception("ControlBasisFunction: unknown basis " + basis);
+    }
+    if (!evaluator) {
+        throw Exception("ControlBasisFunction: degree must be between 1 "
+                        "and " + std::to_string(maxDegree));
+    }
+    if (!(get_start_time() < get_end_time())) {
+        throw Exception("ControlBasisFunction: start time must precede the "
+                        "end time");
+    }
+    int n = getProperty_coefficients().size();
+    bool valid = basis == "bspline" ? n > degree
+                                    : n > degree && (n - 1) % degree == 0;
+    if (!valid) {
+        throw Exception("ControlBasisFunction: " + std::to_string(n) +
+                        " coefficients do not form a " + basis +
+                        " of degree " + std::to_string(degree));
+    }
+    values.resize(n);
+    for (int i = 0; i < n; i++) values[i] = get_coefficients(i);
+}
+
+double ControlBasisFunction::calcValue(const Vector& x) const {
+    if (!evaluator) throw Exception("ControlBasisFunction: no coefficients");
+    return evaluator(&values[0], values.size(), get_start_time(),
+                     get_end_time(), x[0], 0);
+}
+
+double ControlBasisFunction::calcDerivative(
+        const std::vector<int>& derivComponents, const Vector& x) const {
+    if (!evaluator) throw Exception("ControlBasisFunction: no coefficients");
+    return evaluator(&values[0], values.size(), get_start_time(),
+                     get_end_time(), x[0], int(derivComponents.size()));
+}
+
+int ControlBasisFunction::getMaxDerivativeOrder() const {
+    return maxDegree + 1;
+}
+
+SimTK::Function* ControlBasisFunction::createSimTKFunction() const {
+    if (!evaluator) throw Exception("ControlBasisFunction: no coefficients");
+    return new BasisFunction(evaluator, values, get_start_time(),
+                             get_end_time());
+}
+
+void ControlBasisFunction::updateFromXMLNode(SimTK::Xml::Element& node,
+                                             int versionNumber) {
+    Super::updateFromXMLNode(node, versionNumber);
+    applyProperties();
+}
@@ -0,0 +1,88 @@
+/**
+ * @file ControlBasisFunction.h
+ *
+ * \brief A smooth control function whose coefficients are the parameters of
+ * an optimization.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef CONTROL_BASIS_FUNCTION_H
+#define CONTROL_BASIS_FUNCTION_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Common/Function.h>
+#include <string>
+
+namespace OpenSim {
+/**
+ * \brief A function of time that is a uniform B-spline ("bspline") or a
+ * piecewise Bezier curve ("bezier") over [start_time, end_time] (see
+ * ControlBasis.h).
+ *
+ * The evaluation locates the segment in constant time and runs a kernel
+ * that is instantiated for each supported degree (1 to 5), which is selected
+ * when the properties are applied. The properties are applied on
+ * construction, when the function is read from a file and by
+ * setCoefficients(); they should not be modified otherwise.
+ */
+class SimulationTools_API ControlBasisFunction : public Function {
+    OpenSim_DECLARE_CONCRETE_OBJECT(ControlBasisFunction, Function);
+
+ public:
+    OpenSim_DECLARE_PROPERTY(basis, std::string,
+                             "Basis of the function: bspline (uniform "
+                             "B-spline) or bezier (piecewise Bezier "
+                             "curve).");
+    OpenSim_DECLARE_PROPERTY(degree, int,
+                             "Polynomial degree of the basis (1 to 5).");
+    OpenSim_DECLARE_PROPERTY(start_time, double,
+                             "Beginning of the uniform grid; the value is "
+                             "constant before it.");
+    OpenSim_DECLARE_PROPERTY(end_time, double,
+                             "End of the uniform grid; the value is "
+                             "constant after it.");
+    OpenSim_DECLARE_LIST_PROPERTY(coefficients, double,
+                                  "Coefficients (control points) of the "
+                                  "basis.");
+
+    ControlBasisFunction();
+    ControlBasisFunction(const std::string& basis, int degree,
+                         double startTime, double endTime,
+                         const SimTK::Vector& coefficients);
+
+    /** Replaces the coefficients, e.g., with the parameters of an
+     * optimization. The number of coefficients may change. */
+    void setCoefficients(const SimTK::Vector& coefficients);
+    const SimTK::Vector& getCoefficients() const { return values; }
+
+    /** Number of coefficients of a basis with the given number of
+     * segments. */
+    static int getNumCoefficients(const std::string& basis, int degree,
+                                  int numSegments);
+
+    double calcValue(const SimTK::Vector& x) const override;
+    double calcDerivative(const std::vector<int>& derivComponents,
+                          const SimTK::Vector& x) const override;
+    int getArgumentSize() const override { return 1; }
+    int getMaxDerivativeOrder() const override;
+    SimTK::Function* createSimTKFunction() const override;
+
+    void updateFromXMLNode(SimTK::Xml::Element& node,
+                           int versionNumber) override;
+
+    typedef double (*Evaluator)(const double* c, int n, double t0, double t1,
+                                double t, int order);
+
+ private:
+    void constructProperties();
+    // Validates the properties and selects the kernel.
+    void applyProperties();
+
+    Evaluator evaluator = nullptr;
+    // The coefficients in contiguous memory.
+    SimTK::Vector values;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,70 @@
+#include "ControlSwitchEvent.h"
+
+#include <OpenSim/Common/PiecewiseConstantFunction.h>
+#include <OpenSim/Common/PiecewiseLinearFunction.h>
+#include <OpenSim/Simulation/Control/PrescribedController.h>
+#include <algorithm>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+ControlSwitchEvent::ControlSwitchEvent(const std::vector<double>& times)
+        : times(times) {
+    std::sort(this->times.begin(), this->times.end());
+    this->times.erase(std::unique(this->times.begin(), this->times.end()),
+                      this->times.end());
+}
+
+Real ControlSwitchEvent::getNextEventTime(const State& s,
+                                          bool includeCurrentTime) const {
+    auto next = includeCurrentTime
+                        ? std::lower_bound(times.begin(), times.end(),
+                                           s.getTime())
+                        : std::upper_bound(times.begin(), times.end(),
+                                           s.getTime());
+    return next == times.end() ? Infinity : *next;
+}
+
+void ControlSwitchEvent::handleEvent(State& s, Real accuracy,
+                                     bool& shouldTerminate) const {
+    // The integrator is restarted after the event; nothing else to do.
+    shouldTerminate = false;
+}
+
+std::vector<double> ControlSwitchEvent::getSwitchingTimes(const Model& model) {
+    std::vector<double> times;
+    const auto& controllers = model.getControllerSet();
+    for (int i = 0; i < controllers.getSize(); i++) {
+        auto controller =
+                dynamic_cast<const PrescribedController*>(&controllers.get(i));
+        if (!controller) continue;
+        const auto& functions = controller->get_ControlFunctions();
+        for (int j = 0; j < functions.getSize(); j++) {
+            const auto* function = &functions.get(j);
+            if (auto constant =
+                        dynamic_cast<const PiecewiseConstantFunction*>(
+                                function)) {
+                for (int k = 0; k < constant->getSize(); k++) {
+                    times.push_back(constant->getX(k));
+                }
+            } else if (auto linear =
+                               dynamic_cast<const PiecewiseLinearFunction*>(
+                                       function)) {
+                for (int k = 0; k < linear->getSize(); k++) {
+                    times.push_back(linear->getX(k));
+                }
+            }
+        }
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    return times;
+}
+
+ControlSwitchEvent* ControlSwitchEvent::addToModel(Model& model) {
+    auto times = getSwitchingTimes(model);
+    if (times.empty()) return nullptr;
+    auto event = new ControlSwitchEvent(times);
+    model.updMultibodySystem().addEventHandler(event);
+    return event;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file ControlSwitchEvent.h
+ *
+ * \brief Scheduled events at the discontinuities of piecewise controls.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef CONTROL_SWITCH_EVENT_H
+#define CONTROL_SWITCH_EVENT_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Stops the integration at the switching times of the controls.
+ *
+ * A piecewise constant control is discontinuous at its knots (and a piecewise
+ * linear control has a discontinuous derivative). An adaptive integrator that
+ * steps over such a switch fails the error test and shrinks the step until
+ * the switch is passed. A scheduled event instead ends the step exactly at
+ * the switch, after which the integrator is restarted from the state at that
+ * time. The handler does not modify the state, therefore, the trajectory is
+ * only affected by the improved accuracy around the switches.
+ *
+ * The event must be added to the system after Model::buildSystem() and before
+ * Model::initializeState() (see addToModel()). The switching times are read
+ * when the event is created; the values of the controls may change.
+ */
+class SimulationTools_API ControlSwitchEvent
+        : public SimTK::ScheduledEventHandler {
+ public:
+    /** The switching times need not be sorted. */
+    explicit ControlSwitchEvent(const std::vector<double>& times);
+
+    SimTK::Real getNextEventTime(const SimTK::State& s,
+                                 bool includeCurrentTime) const override;
+    void handleEvent(SimTK::State& s, SimTK::Real accuracy,
+                     bool& shouldTerminate) const override;
+
+    const std::vector<double>& getTimes() const { return times; }
+
+    /** The knots of the piecewise constant and piecewise linear functions of
+     * the PrescribedControllers of the model (sorted, without duplicates). */
+    static std::vector<double> getSwitchingTimes(const Model& model);
+    /** Adds an event at the switching times of the model to its system,
+     * which takes ownership. Returns nullptr if the model has no piecewise
+     * controls. */
+    static ControlSwitchEvent* addToModel(Model& model);
+
+ private:
+    std::vector<double> times;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * @file ConvertStorage.cpp
+ *
+ * \brief Converts a storage file from text (.sto) to binary (.osb) format and
+ * vice versa, depending on the extension of the input file.
+ *
+ * Usage: ConvertStorage input output
+ *
+ * @author agent <agent@local>
+ */
+#include "BinaryStorage.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+
+bool hasExtension(const string& fileName, const string& extension) {
+    return fileName.size() >= extension.size() &&
+           fileName.compare(fileName.size() - extension.size(),
+                            extension.size(), extension) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cout << "usage: " << argv[0] << " input output" << endl;
+        return -1;
+    }
+    try {
+        if (hasExtension(argv[1], ".osb")) {
+            BinaryStorage::convertToSto(argv[1], argv[2]);
+        } else {
+            BinaryStorage::convertFromSto(argv[1], argv[2]);
+        }
+    } catch (exception& e) {
+        cout << typeid(e).name() << ": " << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "EnsembleRunner.h"
+#include "ParallelTasks.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <limits>
+
+using namespace OpenSim;
+using namespace std;
+
+EnsembleRunner::EnsembleRunner(const vector<string>& columnLabels,
+                               int numThreads)
+        : columnLabels(columnLabels), numThreads(numThreads) {}
+
+const vector<EnsembleRunner::Result>& EnsembleRunner::run(int numRuns,
+                                                          const Task& task) {
+    results.assign(numRuns, Result());
+    // Each run writes only its own result, thus, no locking is required.
+    parallelFor(numRuns,
+                [&](int i) {
+                    auto& result = results[i];
+                    auto start = chrono::steady_clock::now();
+                    try {
+                        result.values = task(i);
+                        if (result.values.size() != columnLabels.size()) {
+                            throw Exception("EnsembleRunner: run returned " +
+                                            to_string(result.values.size()) +
+                                            " values, expected " +
+                                            to_string(columnLabels.size()));
+                        }
+                        result.succeeded = true;
+                    } catch (const exception& e) {
+                        result.error = e.what();
+                    } catch (...) {
+                        result.error = "unknown error";
+                    }
+                    result.wallTime = chrono::duration<double>(
+                                              chrono::steady_clock::now() -
+                                              start)
+                                              .count();
+                },
+                numThreads);
+    return results;
+}
+
+int EnsembleRunner::getNumFailures() const {
+    int numFailures = 0;
+    for (const auto& result : results) {
+        if (!result.succeeded) numFailures++;
+    }
+    return numFailures;
+}
+
+double EnsembleRunner::getTotalWallTime() const {
+    double total = 0;
+    for (const auto& result : results) total += result.wallTime;
+    return total;
+}
+
+void EnsembleRunner::printResults(const string& fileName) const {
+    ofstream file(fileName);
+    if (!file) throw Exception("EnsembleRunner: cannot write " + fileName);
+    file.precision(numeric_limits<double>::max_digits10);
+    file << "index\tsucceeded\twall_time";
+    for (const auto& label : columnLabels) file << "\t" << label;
+    file << "\n";
+    for (int i = 0; i < (int) results.size(); i++) {
+        const auto& result = results[i];
+        file << i << "\t" << result.succeeded << "\t" << result.wallTime;
+        for (int j = 0; j < (int) columnLabels.size(); j++) {
+            file << "\t";
+            if (result.succeeded) {
+                file << result.values[j];
+            } else {
+                file << "NaN";
+            }
+        }
+        file << "\n";
+    }
+}
+
+void EnsembleRunner::printFailureReport(ostream& out) const {
+    out << getNumFailures() << " of " << results.size() << " runs failed"
+        << endl;
+    for (int i = 0; i < (int) results.size(); i++) {
+        if (!results[i].succeeded) {
+            out << "run " << i << ": " << results[i].error << endl;
+        }
+    }
+}
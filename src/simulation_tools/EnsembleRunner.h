@@ -0,0 +1,67 @@
+/**
+ * @file EnsembleRunner.h
+ *
+ * \brief Runs an ensemble of independent simulations in parallel and merges
+ * their results into a single indexed table.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef ENSEMBLE_RUNNER_H
+#define ENSEMBLE_RUNNER_H
+
+#include "SimulationToolsExports.h"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Executes a task for each run of an ensemble on a pool of worker
+ * threads.
+ *
+ * A task simulates one run and returns one value per column. An exception
+ * thrown by a task marks only that run as failed (with the message of the
+ * exception). The wall time of each run is recorded.
+ */
+class SimulationTools_API EnsembleRunner {
+ public:
+    typedef std::function<std::vector<double>(int)> Task;
+
+    /** The result of a single run. */
+    struct Result {
+        bool succeeded = false;
+        std::string error;
+        double wallTime = 0;
+        std::vector<double> values;
+    };
+
+    /** The labels of the values returned by a task. If numThreads < 1 the
+     * number of processors is used. */
+    EnsembleRunner(const std::vector<std::string>& columnLabels,
+                   int numThreads = 0);
+
+    /** Executes task(i) for i in [0, numRuns) and returns the results in
+     * the order of the runs. */
+    const std::vector<Result>& run(int numRuns, const Task& task);
+
+    const std::vector<Result>& getResults() const { return results; }
+    int getNumFailures() const;
+    /** Sum of the wall times of all runs (s). */
+    double getTotalWallTime() const;
+
+    /** Prints a table with one row per run (index, succeeded, wall_time and
+     * the values). The values of a failed run are NaN. */
+    void printResults(const std::string& fileName) const;
+    /** Prints the index and the error of each failed run. */
+    void printFailureReport(std::ostream& out) const;
+
+ private:
+    std::vector<std::string> columnLabels;
+    int numThreads;
+    std::vector<Result> results;
+};
+} // namespace OpenSim
+
+#endif
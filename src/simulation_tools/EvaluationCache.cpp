@@ -0,0 +1,140 @@
+#include "EvaluationCache.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace OpenSim;
+using namespace std;
+
+EvaluationCache::EvaluationCache(double tolerance, int capacity,
+                                 const string& fileName,
+                                 const string& signature)
+        : tolerance(tolerance), entries(capacity) {
+    if (tolerance <= 0 || capacity < 1) {
+        throw Exception("EvaluationCache: tolerance and capacity must be "
+                        "positive");
+    }
+    if (fileName.empty()) return;
+    // Append new entries. A new file starts with the header that identifies
+    // the study. The file of a different study is kept aside.
+    bool isNew = !ifstream(fileName).good();
+    bool complete = true;
+    if (!isNew && !load(fileName, signature, complete)) {
+        string staleFileName = fileName + ".stale";
+        remove(staleFileName.c_str());
+        if (rename(fileName.c_str(), staleFileName.c_str()) != 0) {
+            throw Exception("EvaluationCache: cannot rename " + fileName);
+        }
+        isNew = true;
+    }
+    store.open(fileName, isNew ? ios::out : ios::app);
+    store << setprecision(numeric_limits<double>::max_digits10);
+    if (isNew) store << signature << "\n" << tolerance << endl;
+    // The entries are appended after the incomplete line, if any.
+    if (!complete) store << endl;
+}
+
+size_t EvaluationCache::KeyHash::operator()(const Key& key) const {
+    size_t seed = key.size();
+    for (auto k : key) {
+        hashCombine(seed, hash<long long>()(k));
+    }
+    return seed;
+}
+
+bool EvaluationCache::quantize(const SimTK::Vector& parameters,
+                               Key& key) const {
+    // llround is undefined outside the range of long long (about 9.2e18).
+    const double limit = 4e18;
+    key.resize(parameters.size());
+    for (int i = 0; i < parameters.size(); i++) {
+        double cell = parameters[i] / tolerance;
+        if (!(abs(cell) < limit)) return false;
+        key[i] = llround(cell);
+    }
+    return true;
+}
+
+bool EvaluationCache::lookup(const SimTK::Vector& parameters, double& value) {
+    Key key;
+    bool isValid = quantize(parameters, key);
+    lock_guard<std::mutex> lock(mutex);
+    double* cached = isValid ? entries.find(key) : nullptr;
+    if (!cached) {
+        numMisses++;
+        return false;
+    }
+    value = *cached;
+    numHits++;
+    return true;
+}
+
+void EvaluationCache::countHitAsMiss() {
+    lock_guard<std::mutex> lock(mutex);
+    numHits--;
+    numMisses++;
+}
+
+void EvaluationCache::insert(const SimTK::Vector& parameters, double value) {
+    Key key;
+    if (!quantize(parameters, key)) return;
+    lock_guard<std::mutex> lock(mutex);
+    entries.insert(key, value);
+    if (store.is_open()) {
+        // Flushed, so that the entry survives a killed run.
+        store << key.size();
+        for (auto k : key) store << " " << k;
+        store << " " << value << endl;
+    }
+}
+
+bool EvaluationCache::load(const string& fileName, const string& signature,
+                           bool& complete) {
+    ifstream file(fileName);
+    string fileSignature, line;
+    getline(file, fileSignature);
+    getline(file, line);
+    istringstream header(line);
+    double fileTolerance;
+    if (!(header >> fileTolerance) || fileSignature != signature ||
+        fileTolerance != tolerance) {
+        return false;
+    }
+    complete = true;
+    while (getline(file, line)) {
+        // The last line of a killed run may be truncated.
+        if (file.eof()) {
+            complete = false;
+            break;
+        }
+        istringstream entry(line);
+        size_t n;
+        if (!(entry >> n) || n > line.size()) continue;
+        Key key(n);
+        double value;
+        for (size_t i = 0; i < n; i++) entry >> key[i];
+        string rest;
+        if (!(entry >> value) || entry >> rest) continue;
+        entries.insert(key, value);
+    }
+    return true;
+}
+
+int EvaluationCache::getNumHits() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numHits;
+}
+
+int EvaluationCache::getNumMisses() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numMisses;
+}
+
+int EvaluationCache::getSize() const {
+    lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
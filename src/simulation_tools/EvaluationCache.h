@@ -0,0 +1,73 @@
+/**
+ * @file EvaluationCache.h
+ *
+ * \brief A memoizing cache of objective function evaluations.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef EVALUATION_CACHE_H
+#define EVALUATION_CACHE_H
+
+#include "LruCache.h"
+#include "SimulationToolsExports.h"
+
+#include <SimTKcommon.h>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Caches the value of an expensive function of a parameter vector.
+ *
+ * Parameters are quantized on a uniform grid with the given tolerance, thus,
+ * parameter vectors that fall in the same grid cell share an entry. The cache
+ * holds at most capacity entries and evicts the least recently used entry
+ * when full. Parameters that cannot be quantized (not finite or too large
+ * for the grid) are never cached. Optionally, entries are appended to a
+ * file, which is loaded on construction. Each entry is flushed when it is
+ * inserted and an incomplete last entry is ignored. The signature identifies
+ * the study and a file that was created with a different signature or
+ * tolerance is ignored: it is renamed with the suffix ".stale" and the cache
+ * starts empty. All methods are thread-safe.
+ */
+class SimulationTools_API EvaluationCache {
+ public:
+    EvaluationCache(double tolerance, int capacity,
+                    const std::string& fileName = "",
+                    const std::string& signature = "");
+
+    /** Returns true and sets the value if the parameters are cached. */
+    bool lookup(const SimTK::Vector& parameters, double& value);
+    /** Counts the last hit as a miss, if its value was not used (e.g., the
+     * function was evaluated again). */
+    void countHitAsMiss();
+    /** Inserts (or updates) the value of the parameters. */
+    void insert(const SimTK::Vector& parameters, double value);
+
+    int getNumHits() const;
+    int getNumMisses() const;
+    int getSize() const;
+
+ private:
+    typedef std::vector<long long> Key;
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    // Returns false if a parameter is outside the range of the grid.
+    bool quantize(const SimTK::Vector& parameters, Key& key) const;
+    // Returns false if the file belongs to a different study. complete is
+    // false if the last line of the file is not terminated.
+    bool load(const std::string& fileName, const std::string& signature,
+              bool& complete);
+
+    double tolerance;
+    LruCache<Key, double, KeyHash> entries;
+    std::ofstream store;
+    int numHits = 0;
+    int numMisses = 0;
+    mutable std::mutex mutex;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,77 @@
+#include "FidelityStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace OpenSim;
+
+void FidelityStatistics::recordEvaluation(Fidelity fidelity, double time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    numEvaluations[fidelity]++;
+    wallTime[fidelity] += time;
+}
+
+void FidelityStatistics::recordPair(double low, double high) {
+    std::lock_guard<std::mutex> lock(mutex);
+    double error = low - high;
+    numPairs++;
+    sumError += error;
+    sumSquaredError += error * error;
+    maxAbsError = std::max(maxAbsError, std::abs(error));
+}
+
+void FidelityStatistics::recordRejection() {
+    std::lock_guard<std::mutex> lock(mutex);
+    numRejections++;
+}
+
+int FidelityStatistics::getNumEvaluations(Fidelity fidelity) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numEvaluations[fidelity];
+}
+
+double FidelityStatistics::getMeanWallTime(Fidelity fidelity) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numEvaluations[fidelity] > 0
+                   ? wallTime[fidelity] / numEvaluations[fidelity]
+                   : std::numeric_limits<double>::quiet_NaN();
+}
+
+int FidelityStatistics::getNumRejections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numRejections;
+}
+
+int FidelityStatistics::getNumPairs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numPairs;
+}
+
+double FidelityStatistics::getBias() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numPairs > 0 ? sumError / numPairs
+                        : std::numeric_limits<double>::quiet_NaN();
+}
+
+double FidelityStatistics::getRMSError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numPairs > 0 ? std::sqrt(sumSquaredError / numPairs)
+                        : std::numeric_limits<double>::quiet_NaN();
+}
+
+double FidelityStatistics::getMaxAbsError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxAbsError;
+}
+
+void FidelityStatistics::print(std::ostream& stream) const {
+    stream << "low fidelity: " << getNumEvaluations(Low) << " evaluations, "
+           << 1000 * getMeanWallTime(Low) << " ms/evaluation" << std::endl
+           << "high fidelity: " << getNumEvaluations(High) << " evaluations, "
+           << 1000 * getMeanWallTime(High) << " ms/evaluation" << std::endl
+           << "rejected by screening: " << getNumRejections() << std::endl
+           << "low - high error over " << getNumPairs()
+           << " candidates: bias " << getBias() << ", rms " << getRMSError()
+           << ", max " << getMaxAbsError() << std::endl;
+}
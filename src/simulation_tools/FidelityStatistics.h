@@ -0,0 +1,59 @@
+/**
+ * @file FidelityStatistics.h
+ *
+ * \brief Statistics of a multi-fidelity evaluation scheme, where candidates
+ * are screened by a cheap (low-fidelity) simulation and only the promising
+ * ones are evaluated by an accurate (high-fidelity) simulation.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef FIDELITY_STATISTICS_H
+#define FIDELITY_STATISTICS_H
+
+#include "SimulationToolsExports.h"
+
+#include <mutex>
+#include <ostream>
+
+namespace OpenSim {
+/**
+ * \brief Collects the cost of each fidelity and the error of the low-fidelity
+ * evaluations with respect to the high-fidelity evaluations of the same
+ * candidates. All methods are thread-safe.
+ */
+class SimulationTools_API FidelityStatistics {
+ public:
+    enum Fidelity { Low = 0, High = 1 };
+
+    /** Records an evaluation and its wall time (s). */
+    void recordEvaluation(Fidelity fidelity, double wallTime);
+    /** Records a candidate that was evaluated at both fidelities. */
+    void recordPair(double low, double high);
+    /** Records a candidate that was rejected by the screening. */
+    void recordRejection();
+
+    int getNumEvaluations(Fidelity fidelity) const;
+    double getMeanWallTime(Fidelity fidelity) const;
+    int getNumRejections() const;
+    int getNumPairs() const;
+    /** Mean of (low - high). */
+    double getBias() const;
+    /** Root mean square of (low - high). */
+    double getRMSError() const;
+    double getMaxAbsError() const;
+
+    void print(std::ostream& stream) const;
+
+ private:
+    int numEvaluations[2] = {0, 0};
+    double wallTime[2] = {0, 0};
+    int numRejections = 0;
+    int numPairs = 0;
+    double sumError = 0;
+    double sumSquaredError = 0;
+    double maxAbsError = 0;
+    mutable std::mutex mutex;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,115 @@
+#include "FiniteDifferenceGradient.h"
+
+#include "ParallelTasks.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+FiniteDifferenceGradient::FiniteDifferenceGradient(const Function& function,
+                                                   Method method,
+                                                   int numThreads)
+        : function(function), method(method), numThreads(numThreads) {}
+
+void FiniteDifferenceGradient::setStepSizes(const Vector& stepSizes) {
+    for (int i = 0; i < stepSizes.size(); i++) {
+        if (stepSizes[i] <= 0) {
+            throw Exception("FiniteDifferenceGradient: step sizes must be "
+                            "positive");
+        }
+    }
+    this->stepSizes = stepSizes;
+}
+
+void FiniteDifferenceGradient::setFunctionAccuracy(double accuracy) {
+    if (!(accuracy > 0)) {
+        throw Exception("FiniteDifferenceGradient: accuracy must be positive");
+    }
+    functionAccuracy = accuracy;
+}
+
+void FiniteDifferenceGradient::setBounds(const double* lower,
+                                         const double* upper) {
+    this->lower = lower;
+    this->upper = upper;
+}
+
+int FiniteDifferenceGradient::getNumEvaluations(int numParameters) const {
+    return method == Forward ? numParameters + 1 : 2 * numParameters;
+}
+
+double FiniteDifferenceGradient::getStepSize(const Vector& x, int i) const {
+    if (stepSizes.size() > 0) return stepSizes[i];
+    // Steps that balance the truncation error and the error of the function
+    // values.
+    double scale = std::max(1.0, std::abs(x[i]));
+    return method == Forward ? std::sqrt(functionAccuracy) * scale
+                             : std::cbrt(functionAccuracy) * scale;
+}
+
+void FiniteDifferenceGradient::compute(const Vector& x,
+                                       Vector& gradient) const {
+    int n = x.size();
+    if (stepSizes.size() > 0 && stepSizes.size() != n) {
+        throw Exception("FiniteDifferenceGradient: wrong number of step "
+                        "sizes");
+    }
+
+    // Prepare all perturbed points.
+    std::vector<Vector> points;
+    std::vector<double> steps(n);
+    if (method == Forward) points.push_back(x);
+    for (int i = 0; i < n; i++) {
+        double h = getStepSize(x, i);
+        if (method == Forward) {
+            // Reverse the step at the upper bound. If it does not fit in
+            // either direction, step to the farther bound.
+            if (upper && x[i] + h > upper[i]) {
+                double above = upper[i] - x[i];
+                if (!lower || x[i] - h >= lower[i]) {
+                    h = -h;
+                } else {
+                    double below = x[i] - lower[i];
+                    h = above >= below ? above : -below;
+                }
+            }
+            Vector xp = x;
+            xp[i] += h;
+            points.push_back(xp);
+        } else {
+            // Shift the stencil [x - h, x + h] inside the bounds.
+            if (lower && upper) h = std::min(h, (upper[i] - lower[i]) / 2);
+            double center = x[i];
+            if (upper && center + h > upper[i]) center = upper[i] - h;
+            if (lower && center - h < lower[i]) center = lower[i] + h;
+            Vector xp = x, xm = x;
+            xp[i] = center + h;
+            xm[i] = center - h;
+            points.push_back(xp);
+            points.push_back(xm);
+        }
+        steps[i] = h;
+    }
+
+    // Evaluate concurrently.
+    std::vector<double> values(points.size());
+    parallelFor(
+            (int) points.size(),
+            [&](int k) { values[k] = function(points[k]); }, numThreads);
+
+    gradient.resize(n);
+    for (int i = 0; i < n; i++) {
+        // a parameter that is fixed by its bounds
+        if (steps[i] == 0) {
+            gradient[i] = 0;
+        } else if (method == Forward) {
+            gradient[i] = (values[i + 1] - values[0]) / steps[i];
+        } else {
+            gradient[i] = (values[2 * i] - values[2 * i + 1]) / (2 * steps[i]);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file FiniteDifferenceGradient.h
+ *
+ * \brief Finite difference approximation of the gradient, where the perturbed
+ * function evaluations are performed in parallel.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef FINITE_DIFFERENCE_GRADIENT_H
+#define FINITE_DIFFERENCE_GRADIENT_H
+
+#include "SimulationToolsExports.h"
+
+#include <SimTKcommon.h>
+#include <functional>
+
+namespace OpenSim {
+/**
+ * \brief Computes the gradient of an expensive function by finite differences.
+ *
+ * All perturbed evaluations of a gradient are independent, therefore, they are
+ * executed concurrently (n + 1 evaluations for forward and 2n for central
+ * differences). The function must be thread-safe. Step sizes can be specified
+ * per parameter, otherwise they are derived from the accuracy of the function
+ * and scaled by the magnitude of the parameter. If parameter bounds are
+ * provided, the direction of a forward difference is reversed and a central
+ * difference is shifted (or the step is shortened if the bounds are closer
+ * than the step), thus, the function is never evaluated outside the bounds.
+ */
+class SimulationTools_API FiniteDifferenceGradient {
+ public:
+    enum Method { Forward, Central };
+    typedef std::function<double(const SimTK::Vector&)> Function;
+
+    FiniteDifferenceGradient(const Function& function,
+                             Method method = Forward, int numThreads = 0);
+
+    void setMethod(Method method) { this->method = method; }
+    /** Relative accuracy of the function values, which determines the
+     * default steps: sqrt(accuracy) for forward and cbrt(accuracy) for
+     * central differences (machine precision by default). */
+    void setFunctionAccuracy(double accuracy);
+    /** Absolute step size per parameter (empty for default steps). */
+    void setStepSizes(const SimTK::Vector& stepSizes);
+    /** Parameter bounds (null for unbounded). */
+    void setBounds(const double* lower, const double* upper);
+
+    /** Computes the gradient of the function at x. */
+    void compute(const SimTK::Vector& x, SimTK::Vector& gradient) const;
+    /** Number of function evaluations per gradient. */
+    int getNumEvaluations(int numParameters) const;
+
+ private:
+    double getStepSize(const SimTK::Vector& x, int i) const;
+
+    Function function;
+    Method method;
+    int numThreads;
+    double functionAccuracy = SimTK::Eps;
+    SimTK::Vector stepSizes;
+    const double* lower = nullptr;
+    const double* upper = nullptr;
+};
+} // namespace OpenSim
+
+#endif
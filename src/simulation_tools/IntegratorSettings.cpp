@@ -0,0 +1,87 @@
+#include "IntegratorSettings.h"
+#include "RolloutContext.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <utility>
+#include <vector>
+
+using namespace OpenSim;
+
+namespace {
+typedef Manager::IntegratorMethod Method;
+const std::vector<std::pair<Method, std::string>> methodNames = {
+        {Method::ExplicitEuler, "ExplicitEuler"},
+        {Method::RungeKutta2, "RungeKutta2"},
+        {Method::RungeKutta3, "RungeKutta3"},
+        {Method::RungeKuttaFeldberg, "RungeKuttaFeldberg"},
+        {Method::RungeKuttaMerson, "RungeKuttaMerson"},
+        {Method::SemiExplicitEuler2, "SemiExplicitEuler2"},
+        {Method::Verlet, "Verlet"}};
+} // namespace
+
+IntegratorSettings::IntegratorSettings() : Object() { constructProperties(); }
+
+IntegratorSettings::IntegratorSettings(Manager::IntegratorMethod method,
+                                       double accuracy,
+                                       double maximumStepSize,
+                                       double fixedStepSize)
+        : Object() {
+    constructProperties();
+    set_integrator_method(getMethodName(method));
+    set_accuracy(accuracy);
+    set_maximum_step_size(maximumStepSize);
+    set_fixed_step_size(fixedStepSize);
+}
+
+IntegratorSettings::IntegratorSettings(const std::string& fileName)
+        : Object(fileName, false) {
+    constructProperties();
+    updateFromXMLDocument();
+}
+
+void IntegratorSettings::constructProperties() {
+    constructProperty_integrator_method("RungeKuttaMerson");
+    constructProperty_accuracy(1e-3);
+    constructProperty_maximum_step_size(0);
+    constructProperty_fixed_step_size(0);
+}
+
+Manager::IntegratorMethod IntegratorSettings::getMethod() const {
+    return getMethod(get_integrator_method());
+}
+
+void IntegratorSettings::applyTo(Manager& manager) const {
+    manager.setIntegratorMethod(getMethod());
+    manager.setIntegratorAccuracy(get_accuracy());
+    if (get_maximum_step_size() > 0) {
+        manager.setIntegratorMaximumStepSize(get_maximum_step_size());
+    }
+    if (get_fixed_step_size() > 0) {
+        manager.setIntegratorFixedStepSize(get_fixed_step_size());
+    }
+}
+
+void IntegratorSettings::applyTo(RolloutContext& context) const {
+    // A context keeps the step sizes of its previous settings, thus, zero
+    // values are also applied.
+    context.setIntegratorMethod(getMethod());
+    context.setAccuracy(get_accuracy());
+    context.setMaximumStepSize(get_maximum_step_size());
+    context.setFixedStepSize(get_fixed_step_size());
+}
+
+std::string
+IntegratorSettings::getMethodName(Manager::IntegratorMethod method) {
+    for (const auto& entry : methodNames) {
+        if (entry.first == method) return entry.second;
+    }
+    throw Exception("IntegratorSettings: unsupported integrator method");
+}
+
+Manager::IntegratorMethod IntegratorSettings::getMethod(
+        const std::string& name) {
+    for (const auto& entry : methodNames) {
+        if (entry.second == name) return entry.first;
+    }
+    throw Exception("IntegratorSettings: unknown integrator method " + name);
+}
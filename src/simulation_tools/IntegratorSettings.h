@@ -0,0 +1,62 @@
+/**
+ * @file IntegratorSettings.h
+ *
+ * \brief Integrator settings that can be saved to and loaded from a file.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef INTEGRATOR_SETTINGS_H
+#define INTEGRATOR_SETTINGS_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Common/Object.h>
+#include <OpenSim/Simulation/Manager/Manager.h>
+
+namespace OpenSim {
+class RolloutContext;
+
+/**
+ * \brief The integration method, accuracy and step sizes of a simulation.
+ *
+ * The settings are stored as XML (print()) and applied to a Manager (before
+ * Manager::initialize) or to a RolloutContext. All settings are applied, thus,
+ * the step sizes of a context are reset to the defaults if they are zero.
+ */
+class SimulationTools_API IntegratorSettings : public Object {
+    OpenSim_DECLARE_CONCRETE_OBJECT(IntegratorSettings, Object);
+
+ public:
+    OpenSim_DECLARE_PROPERTY(integrator_method, std::string,
+                             "Integration method: ExplicitEuler, "
+                             "RungeKutta2, RungeKutta3, RungeKuttaFeldberg, "
+                             "RungeKuttaMerson, SemiExplicitEuler2 or "
+                             "Verlet.");
+    OpenSim_DECLARE_PROPERTY(accuracy, double, "Accuracy of the integrator.");
+    OpenSim_DECLARE_PROPERTY(maximum_step_size, double,
+                             "Maximum step size (zero keeps the default of "
+                             "the integrator).");
+    OpenSim_DECLARE_PROPERTY(fixed_step_size, double,
+                             "Fixed step size, e.g., for methods without "
+                             "error control (zero for error controlled "
+                             "steps).");
+
+    IntegratorSettings();
+    IntegratorSettings(Manager::IntegratorMethod method, double accuracy,
+                       double maximumStepSize = 0, double fixedStepSize = 0);
+    /** Loads the settings from a file. */
+    explicit IntegratorSettings(const std::string& fileName);
+
+    Manager::IntegratorMethod getMethod() const;
+    void applyTo(Manager& manager) const;
+    void applyTo(RolloutContext& context) const;
+
+    static std::string getMethodName(Manager::IntegratorMethod method);
+    static Manager::IntegratorMethod getMethod(const std::string& name);
+
+ private:
+    void constructProperties();
+};
+} // namespace OpenSim
+
+#endif
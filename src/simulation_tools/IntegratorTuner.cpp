@@ -0,0 +1,150 @@
+#include "IntegratorTuner.h"
+#include "RolloutContext.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+namespace {
+// Maximum absolute difference between two storages with the same samples.
+double computeError(const Storage& reference, const Storage& trial) {
+    if (trial.getSize() != reference.getSize()) {
+        throw Exception("IntegratorTuner: the simulation ended at a "
+                        "different time than the reference");
+    }
+    double error = 0;
+    for (int i = 0; i < reference.getSize(); i++) {
+        const auto& x = trial.getStateVector(i)->getData();
+        const auto& xRef = reference.getStateVector(i)->getData();
+        for (int j = 0; j < xRef.getSize(); j++) {
+            error = std::max(error, std::abs(x[j] - xRef[j]));
+        }
+    }
+    return error;
+}
+} // namespace
+
+IntegratorTuner::IntegratorTuner(Model& model, const State& initialState,
+                                 double duration, int numSamples)
+        : model(model), initialState(initialState), duration(duration),
+          numSamples(std::max(numSamples, 1)) {
+    typedef Manager::IntegratorMethod Method;
+    methods = {Method::ExplicitEuler,      Method::RungeKutta2,
+               Method::RungeKutta3,        Method::RungeKuttaFeldberg,
+               Method::RungeKuttaMerson,   Method::SemiExplicitEuler2,
+               Method::Verlet};
+    accuracies = {1e-2, 1e-3, 1e-4, 1e-5, 1e-6};
+    fixedStepSizes = {1e-3, 1e-4, 1e-5};
+}
+
+void IntegratorTuner::setReferenceAccuracy(double accuracy) {
+    referenceAccuracy = accuracy;
+}
+
+void IntegratorTuner::setMethods(
+        const std::vector<Manager::IntegratorMethod>& methods) {
+    this->methods = methods;
+}
+
+void IntegratorTuner::setAccuracies(const std::vector<double>& accuracies) {
+    this->accuracies = accuracies;
+}
+
+void IntegratorTuner::setFixedStepSizes(const std::vector<double>& stepSizes) {
+    fixedStepSizes = stepSizes;
+}
+
+void IntegratorTuner::setRecordedStates(const std::vector<std::string>& names) {
+    recordedStates = names;
+}
+
+void IntegratorTuner::setNumRepetitions(int numRepetitions) {
+    this->numRepetitions = std::max(numRepetitions, 1);
+}
+
+IntegratorSettings IntegratorTuner::tune(double tolerance) {
+    RolloutContext context(model);
+    context.setRecordedStates(recordedStates);
+    context.setReportInterval(duration / numSamples,
+                              RolloutContext::Interpolate);
+
+    IntegratorSettings(Manager::IntegratorMethod::RungeKuttaMerson,
+                       referenceAccuracy)
+            .applyTo(context);
+    context.simulate(initialState, duration);
+    Storage reference(context.getStateStorage());
+
+    // The candidate settings of each method.
+    std::vector<IntegratorSettings> candidates;
+    for (auto method : methods) {
+        IntegratorSettings(method, referenceAccuracy).applyTo(context);
+        if (context.getIntegrator().methodHasErrorControl()) {
+            for (double accuracy : accuracies) {
+                candidates.push_back(IntegratorSettings(method, accuracy));
+            }
+        } else {
+            for (double stepSize : fixedStepSizes) {
+                candidates.push_back(IntegratorSettings(
+                        method, referenceAccuracy, 0, stepSize));
+            }
+        }
+    }
+
+    trials.clear();
+    for (const auto& settings : candidates) {
+        Trial trial;
+        trial.settings = settings;
+        try {
+            trial.settings.applyTo(context);
+            for (int k = 0; k < numRepetitions; k++) {
+                context.simulate(initialState, duration);
+                double wallTime = context.getSetupTime() +
+                                  context.getIntegrationTime();
+                if (k == 0 || wallTime < trial.wallTime) {
+                    trial.wallTime = wallTime;
+                }
+            }
+            trial.numSteps = context.getNumStepsTaken();
+            trial.error = computeError(reference,
+                                       context.getStateStorage());
+        } catch (const std::exception& e) {
+            trial.failure = e.what();
+        }
+        trials.push_back(trial);
+    }
+
+    const Trial* best = nullptr;
+    for (const auto& trial : trials) {
+        if (!trial.failure.empty() || !(trial.error <= tolerance)) continue;
+        if (!best || trial.wallTime < best->wallTime) best = &trial;
+    }
+    if (!best) {
+        throw Exception("IntegratorTuner: no settings reproduce the "
+                        "reference within the tolerance");
+    }
+    return best->settings;
+}
+
+void IntegratorTuner::printReport(std::ostream& out) const {
+    out << std::left << std::setw(20) << "method" << std::right
+        << std::setw(10) << "accuracy" << std::setw(12) << "fixed step"
+        << std::setw(14) << "wall time (ms)"
+        << std::setw(8) << "steps" << std::setw(14) << "error" << std::endl;
+    for (const auto& trial : trials) {
+        out << std::left << std::setw(20)
+            << trial.settings.get_integrator_method() << std::right
+            << std::setw(10) << trial.settings.get_accuracy() << std::setw(12)
+            << trial.settings.get_fixed_step_size();
+        if (trial.failure.empty()) {
+            out << std::setw(14) << 1000 * trial.wallTime << std::setw(8)
+                << trial.numSteps << std::setw(14) << trial.error;
+        } else {
+            out << "  failed: " << trial.failure;
+        }
+        out << std::endl;
+    }
+}
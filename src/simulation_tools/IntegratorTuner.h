@@ -0,0 +1,86 @@
+/**
+ * @file IntegratorTuner.h
+ *
+ * \brief Selects the fastest integrator settings of a model that reproduce a
+ * reference simulation within a given error.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef INTEGRATOR_TUNER_H
+#define INTEGRATOR_TUNER_H
+
+#include "IntegratorSettings.h"
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Tunes the integration method and accuracy of a model.
+ *
+ * A short reference simulation is performed with a tight accuracy. Then, each
+ * combination of the candidate methods and accuracies is simulated and its
+ * trajectory error is computed as the maximum absolute difference from the
+ * reference over the recorded state variables, sampled at equally spaced
+ * times by interpolation. A method without error control (ExplicitEuler)
+ * ignores the accuracy, thus, it is tried with each of the fixed step sizes
+ * instead.
+ * The fastest trial whose error does not exceed the tolerance is selected.
+ * The wall time of a trial is the minimum over the repetitions.
+ */
+class SimulationTools_API IntegratorTuner {
+ public:
+    /** The result of a candidate setting. */
+    struct Trial {
+        IntegratorSettings settings;
+        double wallTime = SimTK::NaN;
+        double error = SimTK::NaN;
+        int numSteps = 0;
+        /** The error message, if the simulation failed. */
+        std::string failure;
+    };
+
+    /** The model must be initialized; the simulations start from the given
+     * state and last duration seconds. */
+    IntegratorTuner(Model& model, const SimTK::State& initialState,
+                    double duration, int numSamples = 100);
+
+    /** Accuracy of the reference simulation (Runge-Kutta-Merson). */
+    void setReferenceAccuracy(double accuracy);
+    /** Candidate methods (all methods by default). */
+    void setMethods(const std::vector<Manager::IntegratorMethod>& methods);
+    /** Candidate accuracies (1e-2 to 1e-6 by default). */
+    void setAccuracies(const std::vector<double>& accuracies);
+    /** Candidate step sizes of the methods without error control (1e-3 to
+     * 1e-5 by default). */
+    void setFixedStepSizes(const std::vector<double>& stepSizes);
+    /** State variables on which the error is computed (all if empty). */
+    void setRecordedStates(const std::vector<std::string>& names);
+    void setNumRepetitions(int numRepetitions);
+
+    /** Runs the reference and all trials and returns the fastest settings
+     * with an error up to the tolerance. Throws if none qualifies. */
+    IntegratorSettings tune(double tolerance);
+    const std::vector<Trial>& getTrials() const { return trials; }
+    /** Prints a table of the trials. */
+    void printReport(std::ostream& out) const;
+
+ private:
+    Model& model;
+    SimTK::State initialState;
+    double duration;
+    int numSamples;
+    double referenceAccuracy = 1e-10;
+    std::vector<Manager::IntegratorMethod> methods;
+    std::vector<double> accuracies;
+    std::vector<double> fixedStepSizes;
+    std::vector<std::string> recordedStates;
+    int numRepetitions = 1;
+    std::vector<Trial> trials;
+};
+} // namespace OpenSim
+
+#endif
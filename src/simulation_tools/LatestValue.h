@@ -0,0 +1,58 @@
+/**
+ * @file LatestValue.h
+ *
+ * \brief A lock-free slot that passes the latest value from a producer thread
+ * to a consumer thread (triple buffering).
+ *
+ * @author agent <agent@local>
+ */
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+#include <atomic>
+
+namespace OpenSim {
+/**
+ * \brief Triple buffer for a single producer and a single consumer.
+ *
+ * The producer writes into back() and calls publish(); the consumer calls
+ * update() and reads front(). Neither side ever waits for the other: values
+ * that are published faster than they are consumed are overwritten, and the
+ * consumer always obtains the most recent complete value. The buffers are
+ * reused, so a value type that keeps its allocation on assignment (e.g.,
+ * SimTK::Vector of a fixed size) does not allocate after the first values.
+ */
+template <typename T> class LatestValue {
+ public:
+    LatestValue() : middle(1) {}
+    LatestValue(const LatestValue&) = delete;
+    LatestValue& operator=(const LatestValue&) = delete;
+
+    /** Buffer to be written by the producer. */
+    T& back() { return slots[backIndex]; }
+    /** Makes the back buffer available to the consumer. */
+    void publish() {
+        backIndex = middle.exchange(backIndex | Fresh) & Index;
+    }
+
+    /** Acquires the latest published value, if a new one is available. */
+    bool update() {
+        if (!(middle.load() & Fresh)) return false;
+        frontIndex = middle.exchange(frontIndex) & Index;
+        return true;
+    }
+    /** Latest value acquired by the consumer. */
+    const T& front() const { return slots[frontIndex]; }
+
+ private:
+    // The middle index is marked as fresh when a value has been published
+    // but not consumed.
+    static const int Index = 3, Fresh = 4;
+    T slots[3];
+    int backIndex = 0;
+    int frontIndex = 2;
+    std::atomic<int> middle;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file LruCache.h
+ *
+ * \brief A map of bounded size that evicts the least recently used entry.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace OpenSim {
+/** Mixes the hash of a value into the hash of a sequence (boost's
+ * hash_combine). */
+inline void hashCombine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+/**
+ * \brief Holds at most capacity entries and evicts the least recently used
+ * entry when full.
+ *
+ * Not synchronized, the owner locks the calls (see EvaluationCache and
+ * PrefixStateCache).
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+ public:
+    explicit LruCache(int capacity) : capacity(capacity) {}
+
+    /** Returns the value of the key and marks it as the most recently used,
+     * or nullptr if the key is not cached. */
+    Value* find(const Key& key) {
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+    /** Inserts (or updates) the value of the key. */
+    void insert(const Key& key, const Value& value) {
+        if (Value* cached = find(key)) {
+            *cached = value;
+            return;
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+        if ((int) entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+    int size() const { return (int) entries.size(); }
+
+ private:
+    typedef std::list<std::pair<Key, Value>> Entries;
+
+    int capacity;
+    // Most recently used entries are in the front.
+    Entries entries;
+    std::unordered_map<Key, typename Entries::iterator, Hash> index;
+};
+} // namespace OpenSim
+
+#endif
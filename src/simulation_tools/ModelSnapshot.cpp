@@ -0,0 +1,177 @@
+#include "ModelSnapshot.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace OpenSim;
+using namespace SimTK;
+using namespace std;
+
+namespace {
+const char magic[4] = {'O', 'S', 'M', 'S'};
+const uint32_t version = 1;
+
+template <typename T> void writeValue(ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T> T readValue(ifstream& file, const string& fileName) {
+    T value;
+    if (!file.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw Exception("ModelSnapshot: " + fileName + " is truncated");
+    }
+    return value;
+}
+
+// The models that are parsed by loadModel, by file name.
+struct ParsedModel {
+    uint64_t hash;
+    unique_ptr<Model> model;
+};
+mutex parsedModelsMutex;
+map<string, ParsedModel> parsedModels;
+} // namespace
+
+ModelSnapshot ModelSnapshot::capture(const Model& model, const State& s,
+                                     const string& sourceFile) {
+    ModelSnapshot snapshot;
+    snapshot.sourceHash = hashFile(sourceFile);
+    snapshot.time = s.getTime();
+    auto stateNames = model.getStateVariableNames();
+    for (int i = 0; i < stateNames.size(); i++) {
+        snapshot.names.push_back(stateNames[i]);
+    }
+    snapshot.values = model.getStateVariableValues(s);
+    return snapshot;
+}
+
+void ModelSnapshot::save(const string& fileName) const {
+    // Concurrent writers (e.g., workers that start together) use different
+    // temporary files; the last rename wins.
+    string temporary = fileName + ".tmp" +
+                       to_string(hash<thread::id>()(this_thread::get_id()));
+    {
+        ofstream file(temporary, ios::binary);
+        if (!file) {
+            throw Exception("ModelSnapshot: cannot write " + temporary);
+        }
+        file.write(magic, sizeof(magic));
+        writeValue(file, version);
+        writeValue(file, sourceHash);
+        writeValue(file, time);
+        writeValue(file, uint64_t(names.size()));
+        for (const auto& name : names) {
+            writeValue(file, uint32_t(name.size()));
+            file.write(name.data(), name.size());
+        }
+        for (int i = 0; i < values.size(); i++) writeValue(file, values[i]);
+        if (!file) {
+            throw Exception("ModelSnapshot: cannot write " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+        // rename does not replace an existing file on all platforms
+        remove(fileName.c_str());
+        if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+            throw Exception("ModelSnapshot: cannot write " + fileName);
+        }
+    }
+}
+
+bool ModelSnapshot::load(const string& fileName) {
+    ifstream file(fileName, ios::binary);
+    if (!file) return false;
+    char fileMagic[4];
+    if (!file.read(fileMagic, sizeof(fileMagic)) ||
+        memcmp(fileMagic, magic, sizeof(magic)) != 0) {
+        throw Exception("ModelSnapshot: " + fileName +
+                        " is not a model snapshot file");
+    }
+    if (readValue<uint32_t>(file, fileName) != version) {
+        throw Exception("ModelSnapshot: " + fileName +
+                        " has an unsupported version or byte order");
+    }
+    sourceHash = readValue<uint64_t>(file, fileName);
+    time = readValue<double>(file, fileName);
+    auto size = readValue<uint64_t>(file, fileName);
+    names.clear();
+    for (uint64_t i = 0; i < size; i++) {
+        string name(readValue<uint32_t>(file, fileName), '\0');
+        if (!file.read(&name[0], name.size())) {
+            throw Exception("ModelSnapshot: " + fileName + " is truncated");
+        }
+        names.push_back(name);
+    }
+    values.resize(int(size));
+    for (int i = 0; i < values.size(); i++) {
+        values[i] = readValue<double>(file, fileName);
+    }
+    return true;
+}
+
+bool ModelSnapshot::isValidFor(const Model& model,
+                               const string& sourceFile) const {
+    if (sourceHash != hashFile(sourceFile)) return false;
+    auto stateNames = model.getStateVariableNames();
+    if (stateNames.size() != int(names.size())) return false;
+    for (int i = 0; i < stateNames.size(); i++) {
+        if (stateNames[i] != names[i]) return false;
+    }
+    return true;
+}
+
+void ModelSnapshot::restore(const Model& model, State& s) const {
+    if (model.getNumStateVariables() != values.size()) {
+        throw Exception("ModelSnapshot: expected " +
+                        to_string(model.getNumStateVariables()) +
+                        " state variables");
+    }
+    s.setTime(time);
+    model.setStateVariableValues(s, values);
+}
+
+uint64_t ModelSnapshot::hashFile(const string& fileName) {
+    ifstream file(fileName, ios::binary);
+    if (!file) throw Exception("ModelSnapshot: cannot read " + fileName);
+    uint64_t hash = 14695981039346656037ull;
+    char buffer[65536];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        for (streamsize i = 0; i < file.gcount(); i++) {
+            hash ^= uint64_t(static_cast<unsigned char>(buffer[i]));
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool ModelSnapshot::equilibrateMuscles(Model& model, State& s,
+                                       const string& sourceFile,
+                                       const string& snapshotFile) {
+    ModelSnapshot snapshot;
+    if (snapshot.load(snapshotFile) &&
+        snapshot.isValidFor(model, sourceFile)) {
+        snapshot.restore(model, s);
+        return true;
+    }
+    model.equilibrateMuscles(s);
+    capture(model, s, sourceFile).save(snapshotFile);
+    return false;
+}
+
+Model ModelSnapshot::loadModel(const string& fileName) {
+    auto hash = hashFile(fileName);
+    lock_guard<mutex> lock(parsedModelsMutex);
+    auto& parsed = parsedModels[fileName];
+    if (!parsed.model || parsed.hash != hash) {
+        parsed.model.reset(new Model(fileName));
+        parsed.hash = hash;
+    }
+    return *parsed.model;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file ModelSnapshot.h
+ *
+ * \brief Snapshot of the equilibrated default state of a model.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef MODEL_SNAPSHOT_H
+#define MODEL_SNAPSHOT_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief The state variables of an initialized model together with a content
+ * hash of the .osim file that the model was loaded from.
+ *
+ * A snapshot file (.oss) consists of the magic "OSMS", the format version
+ * (uint32), the hash of the source file (uint64), the time (float64), the
+ * number of state variables (uint64), their names (uint32 length followed by
+ * the characters) and their values (float64). A snapshot is valid for a
+ * model if the source file has the same hash and the model has the same
+ * state variables; modifications of the model that change the equilibrium
+ * without adding state variables (e.g., a different muscle property set
+ * from code) require a different snapshot file.
+ *
+ * The system of the model must still be built with initSystem(), because
+ * OpenSim cannot restore a built system. To also avoid parsing the XML file
+ * more than once in a process (e.g., one model per worker thread), use
+ * loadModel(), which copies a model that is parsed once.
+ */
+struct SimulationTools_API ModelSnapshot {
+    /** Content hash of the .osim file (see hashFile()). */
+    uint64_t sourceHash = 0;
+    double time = 0;
+    std::vector<std::string> names;
+    SimTK::Vector values;
+
+    /** Captures the state variables of the state. */
+    static ModelSnapshot capture(const Model& model, const SimTK::State& s,
+                                 const std::string& sourceFile);
+    /** Writes the snapshot to a temporary file, which replaces the given
+     * file. */
+    void save(const std::string& fileName) const;
+    /** Returns false if the file does not exist. */
+    bool load(const std::string& fileName);
+    /** True if the snapshot was captured from a model of the source file
+     * with the same state variables. */
+    bool isValidFor(const Model& model, const std::string& sourceFile) const;
+    /** Sets the time and the state variables of the state. */
+    void restore(const Model& model, SimTK::State& s) const;
+
+    /** 64-bit FNV-1a hash of the content of a file. */
+    static uint64_t hashFile(const std::string& fileName);
+    /** Restores the equilibrated state from the snapshot file, if it is
+     * valid, otherwise equilibrates the muscles and saves a new snapshot.
+     * Returns true if the state was restored. */
+    static bool equilibrateMuscles(Model& model, SimTK::State& s,
+                                   const std::string& sourceFile,
+                                   const std::string& snapshotFile);
+    /** Returns a copy of the model of the file, which is parsed only once per
+     * process (and again if the content of the file changes). Thread-safe. */
+    static Model loadModel(const std::string& fileName);
+};
+} // namespace OpenSim
+
+#endif
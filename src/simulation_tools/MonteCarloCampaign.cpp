@@ -0,0 +1,98 @@
+#include "MonteCarloCampaign.h"
+#include "ParallelTasks.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <exception>
+#include <fstream>
+#include <limits>
+
+using namespace OpenSim;
+using namespace std;
+
+MonteCarloCampaign::MonteCarloCampaign(const vector<double>& sampleTimes,
+                                       const vector<string>& outputLabels,
+                                       const vector<double>& probabilities,
+                                       int numThreads)
+        : sampleTimes(sampleTimes), outputLabels(outputLabels),
+          probabilities(probabilities), numThreads(numThreads),
+          moments(sampleTimes.size() * outputLabels.size()) {
+    for (size_t i = 0; i < moments.size(); ++i) {
+        for (double p : probabilities) quantiles.emplace_back(p);
+    }
+}
+
+void MonteCarloCampaign::run(int numNewRuns, const Rollout& rollout) {
+    int first = numRuns + numFailures;
+    size_t numSamples = moments.size();
+    parallelFor(numNewRuns,
+                [&](int i) {
+                    vector<double> samples(numSamples);
+                    string error;
+                    try {
+                        rollout(first + i, samples);
+                        if (samples.size() != numSamples) {
+                            throw Exception(
+                                    "MonteCarloCampaign: rollout returned " +
+                                    to_string(samples.size()) +
+                                    " samples, expected " +
+                                    to_string(numSamples));
+                        }
+                    } catch (const exception& e) {
+                        error = e.what();
+                    } catch (...) {
+                        error = "unknown error";
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error.empty()) {
+                        if (numFailures++ == 0) firstError = error;
+                        return;
+                    }
+                    numRuns++;
+                    for (size_t j = 0; j < numSamples; ++j) {
+                        moments[j].add(samples[j]);
+                        for (size_t k = 0; k < probabilities.size(); ++k) {
+                            quantiles[j * probabilities.size() + k].add(
+                                    samples[j]);
+                        }
+                    }
+                },
+                numThreads);
+}
+
+const RunningMoments& MonteCarloCampaign::getMoments(int time,
+                                                     int output) const {
+    return moments.at(size_t(time) * outputLabels.size() + output);
+}
+
+double MonteCarloCampaign::getQuantile(int time, int output,
+                                       int probability) const {
+    size_t index = size_t(time) * outputLabels.size() + output;
+    return quantiles.at(index * probabilities.size() + probability)
+            .getValue();
+}
+
+void MonteCarloCampaign::printResults(const string& fileName) const {
+    ofstream file(fileName);
+    if (!file) {
+        throw Exception("MonteCarloCampaign: cannot write " + fileName);
+    }
+    file << "time";
+    for (const auto& label : outputLabels) {
+        file << "\t" << label << "_mean\t" << label << "_std";
+        for (double p : probabilities) file << "\t" << label << "_q" << p;
+    }
+    file << "\n";
+    file.precision(numeric_limits<double>::max_digits10);
+    for (int k = 0; k < getNumSampleTimes(); ++k) {
+        file << sampleTimes[k];
+        for (int j = 0; j < getNumOutputs(); ++j) {
+            const auto& moment = getMoments(k, j);
+            file << "\t" << moment.getMean() << "\t"
+                 << moment.getStandardDeviation();
+            for (int p = 0; p < int(probabilities.size()); ++p) {
+                file << "\t" << getQuantile(k, j, p);
+            }
+        }
+        file << "\n";
+    }
+}
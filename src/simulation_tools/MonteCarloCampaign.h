@@ -0,0 +1,85 @@
+/**
+ * @file MonteCarloCampaign.h
+ *
+ * \brief Runs many independent rollouts in parallel and accumulates the
+ * statistics of their outputs without keeping the trajectories.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef MONTE_CARLO_CAMPAIGN_H
+#define MONTE_CARLO_CAMPAIGN_H
+
+#include "SimulationToolsExports.h"
+#include "StreamingStatistics.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Accumulates the mean, the variance and quantiles of each output at
+ * each sample time over the rollouts of a campaign.
+ *
+ * A rollout samples its outputs at the sample times. Its samples are added to
+ * the running statistics (RunningMoments and P2Quantile) as soon as it
+ * finishes, therefore, the memory depends on the number of sample times and
+ * outputs but not on the number of rollouts. The rollouts are executed on a
+ * pool of worker threads; a rollout that throws is counted as a failure and
+ * does not contribute.
+ *
+ * The mean and the variance do not depend on the number of threads up to
+ * round-off, while the quantile estimates depend slightly on the order in
+ * which the rollouts finish.
+ */
+class SimulationTools_API MonteCarloCampaign {
+ public:
+    /** Performs rollout i and writes the value of output j at sample time k
+     * into samples[k * numOutputs + j]. The index identifies the rollout
+     * (e.g., to derive its seed) and is unique over the campaign. */
+    typedef std::function<void(int, std::vector<double>&)> Rollout;
+
+    /** If numThreads < 1 the number of processors is used. */
+    MonteCarloCampaign(const std::vector<double>& sampleTimes,
+                       const std::vector<std::string>& outputLabels,
+                       const std::vector<double>& probabilities = {0.05, 0.5,
+                                                                   0.95},
+                       int numThreads = 0);
+
+    /** Performs numRuns rollouts, whose indices continue those of previous
+     * calls, so that a campaign can be extended in batches. */
+    void run(int numRuns, const Rollout& rollout);
+
+    int getNumRuns() const { return numRuns; }
+    int getNumFailures() const { return numFailures; }
+    /** Error of the first failed rollout, if any. */
+    const std::string& getFirstError() const { return firstError; }
+
+    int getNumSampleTimes() const { return int(sampleTimes.size()); }
+    int getNumOutputs() const { return int(outputLabels.size()); }
+    const RunningMoments& getMoments(int time, int output) const;
+    /** Estimate of the quantile of the probability with the given index. */
+    double getQuantile(int time, int output, int probability) const;
+
+    /** Prints a table with one row per sample time and the mean, standard
+     * deviation and quantiles of each output. */
+    void printResults(const std::string& fileName) const;
+
+ private:
+    std::vector<double> sampleTimes;
+    std::vector<std::string> outputLabels;
+    std::vector<double> probabilities;
+    int numThreads;
+    // per sample time and output
+    std::vector<RunningMoments> moments;
+    // per sample time, output and probability
+    std::vector<P2Quantile> quantiles;
+    int numRuns = 0;
+    int numFailures = 0;
+    std::string firstError;
+    std::mutex mutex;
+};
+} // namespace OpenSim
+
+#endif
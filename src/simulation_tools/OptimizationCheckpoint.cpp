@@ -0,0 +1,98 @@
+#include "OptimizationCheckpoint.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+using namespace OpenSim;
+using namespace SimTK;
+using namespace std;
+
+namespace {
+void writeVector(ostream& stream, const string& name, const Vector& vector) {
+    stream << name << " " << vector.size();
+    for (int i = 0; i < vector.size(); i++) stream << " " << vector[i];
+    stream << "\n";
+}
+
+void readVector(istream& stream, Vector& vector) {
+    int n;
+    stream >> n;
+    vector.resize(n);
+    for (int i = 0; i < n; i++) stream >> vector[i];
+}
+} // namespace
+
+void OptimizationCheckpoint::save(const string& fileName) const {
+    string temporary = fileName + ".tmp";
+    {
+        ofstream file(temporary);
+        if (!file.good()) {
+            throw Exception("OptimizationCheckpoint: cannot write " +
+                            temporary);
+        }
+        file << setprecision(numeric_limits<double>::max_digits10);
+        // Non-finite values are omitted, because they cannot be read back.
+        file << "num_evaluations " << numEvaluations << "\n";
+        if (isfinite(bestObjective)) {
+            file << "best_objective " << bestObjective << "\n";
+        }
+        if (isfinite(stepSize)) file << "step_size " << stepSize << "\n";
+        writeVector(file, "incumbent", incumbent);
+        writeVector(file, "mean", mean);
+    }
+    if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+        // rename does not replace an existing file on all platforms
+        remove(fileName.c_str());
+        if (rename(temporary.c_str(), fileName.c_str()) != 0) {
+            throw Exception("OptimizationCheckpoint: cannot write " +
+                            fileName);
+        }
+    }
+}
+
+bool OptimizationCheckpoint::load(const string& fileName) {
+    ifstream file(fileName);
+    if (!file.good()) return false;
+    string key;
+    while (file >> key) {
+        if (key == "num_evaluations") {
+            file >> numEvaluations;
+        } else if (key == "best_objective") {
+            file >> bestObjective;
+        } else if (key == "step_size") {
+            file >> stepSize;
+        } else if (key == "incumbent") {
+            readVector(file, incumbent);
+        } else if (key == "mean") {
+            readVector(file, mean);
+        } else {
+            throw Exception("OptimizationCheckpoint: unknown entry " + key +
+                            " in " + fileName);
+        }
+    }
+    return true;
+}
+
+void OptimizationCheckpoint::estimateDistribution(
+        const vector<Vector>& samples, Vector& mean, double& stepSize) {
+    if (samples.empty()) {
+        throw Exception("OptimizationCheckpoint: no samples");
+    }
+    int n = samples[0].size();
+    mean.resize(n);
+    mean = 0;
+    for (const auto& sample : samples) mean += sample;
+    mean /= samples.size();
+
+    // Samples of CMA-ES are m + sigma * N(0, C). Assuming that C is close to
+    // the identity, sigma is the root mean square deviation per coordinate.
+    double sum = 0;
+    for (const auto& sample : samples) sum += (sample - mean).normSqr();
+    stepSize = samples.size() > 1
+                       ? sqrt(sum / ((samples.size() - 1) * n))
+                       : NaN;
+}
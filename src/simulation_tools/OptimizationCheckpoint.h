@@ -0,0 +1,55 @@
+/**
+ * @file OptimizationCheckpoint.h
+ *
+ * \brief Checkpoint of the progress of an optimization.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef OPTIMIZATION_CHECKPOINT_H
+#define OPTIMIZATION_CHECKPOINT_H
+
+#include "SimulationToolsExports.h"
+
+#include <SimTKcommon.h>
+#include <string>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief The state of an optimization at a given evaluation.
+ *
+ * SimTK::Optimizer does not expose the internal state of its algorithms,
+ * therefore, the search distribution of CMA-ES (mean and step size) is
+ * estimated from the samples of the last generation (see
+ * estimateDistribution()). An optimizer is warm started from the mean with
+ * the estimated step size (CMA-ES option "init_stepsize"). The covariance
+ * matrix is not recovered and adapts again after the restart.
+ */
+struct SimulationTools_API OptimizationCheckpoint {
+    /** Number of objective evaluations so far. */
+    int numEvaluations = 0;
+    /** Best objective value so far. */
+    double bestObjective = SimTK::Infinity;
+    /** Parameters of the best objective value. */
+    SimTK::Vector incumbent;
+    /** Estimated mean of the search distribution. */
+    SimTK::Vector mean;
+    /** Estimated step size of the search distribution. */
+    double stepSize = SimTK::NaN;
+
+    /** Writes the checkpoint to a temporary file, which replaces the given
+     * file. */
+    void save(const std::string& fileName) const;
+    /** Returns false if the file does not exist. */
+    bool load(const std::string& fileName);
+
+    /** Estimates the mean and the isotropic step size of the distribution
+     * that generated the samples. This is a heuristic: it is accurate only if
+     * the samples are the last generation of the optimizer (e.g., no
+     * finite difference points or duplicates). */
+    static void estimateDistribution(const std::vector<SimTK::Vector>& samples,
+                                     SimTK::Vector& mean, double& stepSize);
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,128 @@
+#include "OutputReducer.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <algorithm>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+OutputReducer::OutputReducer() : Analysis() {
+    constructProperties();
+    reset();
+}
+
+OutputReducer::OutputReducer(const std::string& componentPath,
+                             const std::string& outputName,
+                             const std::string& operation, int outputIndex)
+        : Analysis() {
+    constructProperties();
+    set_component_path(componentPath);
+    set_output_name(outputName);
+    set_operation(operation);
+    set_output_index(outputIndex);
+    setName(outputName + "_" + operation);
+    reset();
+}
+
+void OutputReducer::constructProperties() {
+    constructProperty_component_path("");
+    constructProperty_output_name("unassigned");
+    constructProperty_output_index(0);
+    constructProperty_operation("max");
+}
+
+void OutputReducer::setModel(Model& model) {
+    Super::setModel(model);
+    scalarOutput = nullptr;
+    vectorOutput = nullptr;
+}
+
+void OutputReducer::resolveOutput() {
+    if (get_operation() == "max") {
+        op = Max;
+    } else if (get_operation() == "min") {
+        op = Min;
+    } else if (get_operation() == "integral") {
+        op = Integral;
+    } else if (get_operation() == "final") {
+        op = Final;
+    } else {
+        throw Exception("OutputReducer: unknown operation " +
+                        get_operation());
+    }
+
+    const Component& component =
+            get_component_path().empty()
+                    ? static_cast<const Component&>(*_model)
+                    : _model->getComponent(get_component_path());
+    const AbstractOutput& output = component.getOutput(get_output_name());
+    scalarOutput = dynamic_cast<const Output<double>*>(&output);
+    vectorOutput = dynamic_cast<const Output<Vec3>*>(&output);
+    if (!scalarOutput && !vectorOutput) {
+        throw Exception("OutputReducer: output " + get_output_name() +
+                        " is neither double nor Vec3");
+    }
+    if (vectorOutput && (get_output_index() < 0 || get_output_index() > 2)) {
+        throw Exception("OutputReducer: invalid output_index");
+    }
+}
+
+double OutputReducer::evaluate(const State& s) const {
+    if (scalarOutput) {
+        _model->getMultibodySystem().realize(s,
+                                             scalarOutput->getDependsOnStage());
+        return scalarOutput->getValue(s);
+    }
+    _model->getMultibodySystem().realize(s, vectorOutput->getDependsOnStage());
+    return vectorOutput->getValue(s)[get_output_index()];
+}
+
+void OutputReducer::reset() {
+    accumulator.value = NaN;
+    accumulator.lastTime = NaN;
+    accumulator.lastSample = NaN;
+    accumulator.numSamples = 0;
+}
+
+void OutputReducer::update(const State& s) {
+    if (!scalarOutput && !vectorOutput) resolveOutput();
+    double sample = evaluate(s);
+    double t = s.getTime();
+    auto& a = accumulator;
+    if (a.numSamples == 0) {
+        a.value = op == Integral ? 0 : sample;
+    } else {
+        switch (op) {
+        case Max: a.value = std::max(a.value, sample); break;
+        case Min: a.value = std::min(a.value, sample); break;
+        case Integral:
+            a.value += 0.5 * (t - a.lastTime) * (sample + a.lastSample);
+            break;
+        case Final: a.value = sample; break;
+        }
+    }
+    a.lastTime = t;
+    a.lastSample = sample;
+    a.numSamples++;
+}
+
+int OutputReducer::begin(const State& s) {
+    if (!proceed()) return 0;
+    resolveOutput();
+    reset();
+    update(s);
+    return 0;
+}
+
+int OutputReducer::step(const State& s, int stepNumber) {
+    if (!proceed(stepNumber)) return 0;
+    update(s);
+    return 0;
+}
+
+int OutputReducer::end(const State& s) {
+    if (!proceed()) return 0;
+    // The last step may already have been reduced.
+    if (s.getTime() != accumulator.lastTime) update(s);
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file OutputReducer.h
+ *
+ * \brief An analysis that reduces a model Output to a single scalar while the
+ * simulation advances.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef OUTPUT_REDUCER_H
+#define OUTPUT_REDUCER_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Common/ComponentOutput.h>
+#include <OpenSim/Simulation/Model/Analysis.h>
+
+namespace OpenSim {
+/**
+ * \brief Reduces a scalar or Vec3 model Output on-the-fly.
+ *
+ * The reducer is updated at each accepted integration step, therefore, it does
+ * not store the time series of the Output.
+ *
+ * Supported operations:
+ *
+ * - max: maximum value
+ * - min: minimum value
+ * - integral: trapezoidal integral over time
+ * - final: value at the last step
+ */
+class SimulationTools_API OutputReducer : public Analysis {
+    OpenSim_DECLARE_CONCRETE_OBJECT(OutputReducer, Analysis);
+
+ public:
+    OpenSim_DECLARE_PROPERTY(component_path, std::string,
+                             "Path of the component that owns the output "
+                             "(empty for the model).");
+    OpenSim_DECLARE_PROPERTY(output_name, std::string,
+                             "Name of the output to be reduced.");
+    OpenSim_DECLARE_PROPERTY(output_index, int,
+                             "Element of a Vec3 output (ignored for scalar "
+                             "outputs).");
+    OpenSim_DECLARE_PROPERTY(operation, std::string,
+                             "Reduction operation: max, min, integral or "
+                             "final.");
+
+    OutputReducer();
+    OutputReducer(const std::string& componentPath,
+                  const std::string& outputName, const std::string& operation,
+                  int outputIndex = 0);
+
+    /** Intermediate result of the reduction, which can be stored and
+     * restored to resume a simulation from an intermediate state. */
+    struct Accumulator {
+        double value;
+        double lastTime;
+        double lastSample;
+        int numSamples;
+    };
+
+    /** The reduced value of the last simulation. */
+    double getValue() const { return accumulator.value; }
+    /** Number of steps that were reduced. */
+    int getNumSamples() const { return accumulator.numSamples; }
+    const Accumulator& getAccumulator() const { return accumulator; }
+    void setAccumulator(const Accumulator& a) { accumulator = a; }
+    /** Evaluates the output at the given state. */
+    double evaluate(const SimTK::State& s) const;
+    /** Clears the reduction. */
+    void reset();
+    /** Accumulates a sample of the output. */
+    void update(const SimTK::State& s);
+
+    void setModel(Model& model) override;
+    int begin(const SimTK::State& s) override;
+    int step(const SimTK::State& s, int stepNumber) override;
+    int end(const SimTK::State& s) override;
+
+ private:
+    enum Operation { Max, Min, Integral, Final };
+    void constructProperties();
+    void resolveOutput();
+
+    Operation op;
+    // Resolved at begin() or at the first update of a resumed simulation.
+    const Output<double>* scalarOutput = nullptr;
+    const Output<SimTK::Vec3>* vectorOutput = nullptr;
+    Accumulator accumulator;
+};
+} // namespace OpenSim
+
+#endif
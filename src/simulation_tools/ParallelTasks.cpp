@@ -0,0 +1,79 @@
+#include "ParallelTasks.h"
+
+#include <SimTKcommon.h>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace OpenSim;
+
+namespace {
+// Adapts a std::function to SimTK's task interface and captures exceptions,
+// because exceptions must not escape a worker thread.
+class FunctionTask : public SimTK::ParallelExecutor::Task {
+ public:
+    FunctionTask(const std::function<void(int)>& task) : task(task) {}
+    void execute(int index) override {
+        try {
+            task(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+    void rethrow() const {
+        if (error) std::rethrow_exception(error);
+    }
+
+ private:
+    const std::function<void(int)>& task;
+    std::mutex mutex;
+    std::exception_ptr error;
+};
+
+// An executor that is kept for the lifetime of the process, so that its
+// threads are not created by each parallel loop.
+struct SharedExecutor {
+    std::mutex mutex;
+    std::unique_ptr<SimTK::ParallelExecutor> executor;
+};
+
+SharedExecutor& getSharedExecutor(int numThreads) {
+    static std::mutex mapMutex;
+    static std::map<int, std::unique_ptr<SharedExecutor>> executors;
+    std::lock_guard<std::mutex> lock(mapMutex);
+    auto& shared = executors[numThreads];
+    if (!shared) {
+        shared.reset(new SharedExecutor());
+        shared->executor.reset(new SimTK::ParallelExecutor(numThreads));
+    }
+    return *shared;
+}
+} // namespace
+
+int OpenSim::getDefaultNumThreads() {
+    return SimTK::ParallelExecutor::getNumProcessors();
+}
+
+void OpenSim::parallelFor(int n, const std::function<void(int)>& task,
+                          int numThreads) {
+    if (numThreads < 1) numThreads = getDefaultNumThreads();
+    if (n <= 1 || numThreads == 1 ||
+        SimTK::ParallelExecutor::isWorkerThread()) {
+        for (int i = 0; i < n; i++) task(i);
+        return;
+    }
+    FunctionTask functionTask(task);
+    // The shared executor serves one loop at a time. A loop that is started
+    // concurrently by another thread uses a temporary executor.
+    auto& shared = getSharedExecutor(numThreads);
+    std::unique_lock<std::mutex> lock(shared.mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        shared.executor->execute(functionTask, n);
+    } else {
+        SimTK::ParallelExecutor executor(numThreads);
+        executor.execute(functionTask, n);
+    }
+    functionTask.rethrow();
+}
@@ -0,0 +1,32 @@
+/**
+ * @file ParallelTasks.h
+ *
+ * \brief Utilities for executing independent tasks in parallel using SimTK's
+ * thread pool.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef PARALLEL_TASKS_H
+#define PARALLEL_TASKS_H
+
+#include "SimulationToolsExports.h"
+
+#include <functional>
+
+namespace OpenSim {
+/**
+ * Executes task(i) for i in [0, n) on numThreads threads. If numThreads < 1
+ * the number of processors is used. The threads of each thread count are
+ * created once and reused by later calls. Tasks are executed serially when
+ * called from within a worker thread, so that nested parallel loops do not
+ * oversubscribe the machine. The first exception thrown by a task is rethrown
+ * on the calling thread after all tasks have finished.
+ */
+SimulationTools_API void parallelFor(int n,
+                                     const std::function<void(int)>& task,
+                                     int numThreads = 0);
+/** Number of threads used by parallelFor when numThreads < 1. */
+SimulationTools_API int getDefaultNumThreads();
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,63 @@
+#include "PrefixStateCache.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <cstring>
+
+using namespace OpenSim;
+using namespace std;
+
+PrefixStateCache::PrefixStateCache(int capacity) : entries(capacity) {
+    if (capacity < 1) {
+        throw Exception("PrefixStateCache: capacity must be positive");
+    }
+}
+
+size_t PrefixStateCache::KeyHash::operator()(const Key& key) const {
+    size_t seed = key.size();
+    for (auto k : key) {
+        // -0.0 == 0.0, thus, they must have the same hash
+        double value = k == 0 ? 0.0 : k;
+        unsigned long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        hashCombine(seed, hash<unsigned long long>()(bits));
+    }
+    return seed;
+}
+
+int PrefixStateCache::lookup(const SimTK::Vector& parameters, int maxLength,
+                             Snapshot& snapshot) {
+    lock_guard<std::mutex> lock(mutex);
+    for (int length = maxLength; length >= 1; length--) {
+        Key key(&parameters[0], &parameters[0] + length);
+        auto cached = entries.find(key);
+        if (!cached) continue;
+        snapshot = *cached;
+        numHits++;
+        return length;
+    }
+    numMisses++;
+    return 0;
+}
+
+void PrefixStateCache::insert(const SimTK::Vector& parameters, int length,
+                              const Snapshot& snapshot) {
+    Key key(&parameters[0], &parameters[0] + length);
+    lock_guard<std::mutex> lock(mutex);
+    // The snapshot of a stored prefix is identical, thus, it is not copied.
+    if (!entries.find(key)) entries.insert(key, snapshot);
+}
+
+int PrefixStateCache::getNumHits() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numHits;
+}
+
+int PrefixStateCache::getNumMisses() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numMisses;
+}
+
+int PrefixStateCache::getSize() const {
+    lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
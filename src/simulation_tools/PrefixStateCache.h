@@ -0,0 +1,73 @@
+/**
+ * @file PrefixStateCache.h
+ *
+ * \brief A cache of intermediate simulation states keyed on the prefix of the
+ * control parameters that produced them.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef PREFIX_STATE_CACHE_H
+#define PREFIX_STATE_CACHE_H
+
+#include "LruCache.h"
+#include "OutputReducer.h"
+#include "SimulationToolsExports.h"
+
+#include <SimTKcommon.h>
+#include <mutex>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Stores the states of simulations driven by piecewise constant
+ * controls at the knots of the controls.
+ *
+ * The trajectory up to knot k depends only on the first k + 1 control values
+ * (the integrator evaluates the derivatives at the knot, where the control
+ * function already returns value k), thus, the snapshot of knot k is stored
+ * under a prefix of length k + 1. A simulation whose controls share a prefix
+ * with a previous simulation can be resumed from the deepest stored state,
+ * instead of the initial time. Prefixes are compared exactly (bit-wise), so
+ * that resumed simulations reproduce the results of complete simulations. A
+ * snapshot holds the time, the state variables (Y) and the accumulators of
+ * the reducers, thus, it can be restored in any instance of the same model.
+ * The cache holds at most capacity snapshots and evicts the least recently
+ * used.
+ * All methods are thread-safe.
+ */
+class SimulationTools_API PrefixStateCache {
+ public:
+    struct Snapshot {
+        double time;
+        SimTK::Vector y;
+        std::vector<OutputReducer::Accumulator> reducers;
+    };
+
+    explicit PrefixStateCache(int capacity);
+
+    /** Finds the deepest stored prefix (length in [1, maxLength]) of the
+     * parameters. Returns the length of the prefix (zero if none). */
+    int lookup(const SimTK::Vector& parameters, int maxLength,
+               Snapshot& snapshot);
+    /** Stores the snapshot of the prefix of the given length. */
+    void insert(const SimTK::Vector& parameters, int length,
+                const Snapshot& snapshot);
+
+    int getNumHits() const;
+    int getNumMisses() const;
+    int getSize() const;
+
+ private:
+    typedef std::vector<double> Key;
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    LruCache<Key, Snapshot, KeyHash> entries;
+    int numHits = 0;
+    int numMisses = 0;
+    mutable std::mutex mutex;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,29 @@
+#include "RegisterTypes_SimulationTools.h"
+
+#include "AsyncVisualizer.h"
+#include "ControlBasisFunction.h"
+#include "IntegratorSettings.h"
+#include "OutputReducer.h"
+#include "StreamingStateRecorder.h"
+
+#include <OpenSim/Common/Object.h>
+
+using namespace OpenSim;
+
+static SimulationToolsInstantiator instantiator;
+
+void RegisterTypes_SimulationTools() {
+    Object::RegisterType(ControlBasisFunction());
+    Object::RegisterType(IntegratorSettings());
+    Object::RegisterType(OutputReducer());
+    Object::RegisterType(StreamingStateRecorder());
+    Object::RegisterType(VisualizerPublisher());
+}
+
+SimulationToolsInstantiator::SimulationToolsInstantiator() {
+    registerDllClasses();
+}
+
+void SimulationToolsInstantiator::registerDllClasses() {
+    RegisterTypes_SimulationTools();
+}
@@ -0,0 +1,29 @@
+/**
+ * @file RegisterTypes_SimulationTools.h
+ *
+ * \brief Registers the OpenSim object types of the SimulationTools library.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef REGISTER_TYPES_SIMULATION_TOOLS_H
+#define REGISTER_TYPES_SIMULATION_TOOLS_H
+
+#include "SimulationToolsExports.h"
+
+extern "C" {
+/**
+ * The purpose of this routine is to register all class types exported by
+ * the library.
+ */
+SimulationTools_API void RegisterTypes_SimulationTools();
+}
+
+class SimulationToolsInstantiator {
+ public:
+    SimulationToolsInstantiator();
+
+ private:
+    void registerDllClasses();
+};
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file ResourcePool.h
+ *
+ * \brief A thread-safe pool of reusable resources.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef RESOURCE_POOL_H
+#define RESOURCE_POOL_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Owns a fixed number of resources and lends them to worker threads.
+ *
+ * A resource is borrowed with acquire(), which blocks until one is available,
+ * and it is returned to the pool when the Handle goes out of scope. Each
+ * resource is used by at most one thread at a time, thus, a Model can be
+ * shared by a pool of workers.
+ */
+template <typename T> class ResourcePool {
+ public:
+    /** RAII handle of a borrowed resource. */
+    class Handle {
+     public:
+        Handle(ResourcePool* pool, T* resource)
+                : pool(pool), resource(resource) {}
+        Handle(Handle&& other) : pool(other.pool), resource(other.resource) {
+            other.resource = nullptr;
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        ~Handle() {
+            if (resource) pool->release(resource);
+        }
+        T& operator*() const { return *resource; }
+        T* operator->() const { return resource; }
+
+     private:
+        ResourcePool* pool;
+        T* resource;
+    };
+
+    /** Adds a resource to the pool. The pool takes ownership. */
+    void add(std::unique_ptr<T> resource) {
+        std::lock_guard<std::mutex> lock(mutex);
+        available.push_back(resource.get());
+        resources.push_back(std::move(resource));
+        condition.notify_one();
+    }
+    /** Borrows a resource, waiting until one is available. */
+    Handle acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return !available.empty(); });
+        T* resource = available.back();
+        available.pop_back();
+        return Handle(this, resource);
+    }
+    /** Number of resources owned by the pool. */
+    int size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int) resources.size();
+    }
+    /** Access to a resource by index. Not synchronized, use only when no
+     * resource is borrowed (e.g., for configuration). */
+    T& get(int i) { return *resources[i]; }
+
+ private:
+    void release(T* resource) {
+        std::lock_guard<std::mutex> lock(mutex);
+        available.push_back(resource);
+        condition.notify_one();
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::unique_ptr<T>> resources;
+    std::vector<T*> available;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,223 @@
+#include "RolloutContext.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <OpenSim/Simulation/Model/AnalysisSet.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+namespace {
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+} // namespace
+
+RolloutContext::RolloutContext(Model& model)
+        : model(model), states(1000, "states") {
+    createIntegrator();
+
+    Array<std::string> labels;
+    labels.append("time");
+    auto names = model.getStateVariableNames();
+    for (int i = 0; i < names.getSize(); i++) labels.append(names[i]);
+    states.setColumnLabels(labels);
+}
+
+void RolloutContext::createIntegrator() {
+    const auto& system = model.getMultibodySystem();
+    typedef Manager::IntegratorMethod Method;
+    switch (method) {
+    case Method::ExplicitEuler:
+        integrator.reset(new ExplicitEulerIntegrator(system));
+        break;
+    case Method::RungeKutta2:
+        integrator.reset(new RungeKutta2Integrator(system));
+        break;
+    case Method::RungeKutta3:
+        integrator.reset(new RungeKutta3Integrator(system));
+        break;
+    case Method::RungeKuttaFeldberg:
+        integrator.reset(new RungeKuttaFeldbergIntegrator(system));
+        break;
+    case Method::RungeKuttaMerson:
+        integrator.reset(new RungeKuttaMersonIntegrator(system));
+        break;
+    case Method::SemiExplicitEuler2:
+        integrator.reset(new SemiExplicitEuler2Integrator(system));
+        break;
+    case Method::Verlet:
+        integrator.reset(new VerletIntegrator(system));
+        break;
+    default:
+        throw Exception("RolloutContext: unsupported integrator method");
+    }
+    if (accuracy > 0) integrator->setAccuracy(accuracy);
+    if (maximumStepSize > 0) integrator->setMaximumStepSize(maximumStepSize);
+    if (fixedStepSize > 0) integrator->setFixedStepSize(fixedStepSize);
+    // Every accepted step is returned, so that analyses can be executed.
+    integrator->setReturnEveryInternalStep(true);
+    timeStepper.reset(new TimeStepper(system, *integrator));
+}
+
+void RolloutContext::setIntegratorMethod(Manager::IntegratorMethod method) {
+    this->method = method;
+    createIntegrator();
+}
+
+void RolloutContext::setAccuracy(double accuracy) {
+    this->accuracy = accuracy;
+    integrator->setAccuracy(accuracy);
+}
+
+// The default step sizes are restored by a new integrator.
+void RolloutContext::setMaximumStepSize(double stepSize) {
+    bool reset = !(stepSize > 0) && maximumStepSize > 0;
+    maximumStepSize = std::max(stepSize, 0.0);
+    if (reset) {
+        createIntegrator();
+    } else if (stepSize > 0) {
+        integrator->setMaximumStepSize(stepSize);
+    }
+}
+
+void RolloutContext::setFixedStepSize(double stepSize) {
+    bool reset = !(stepSize > 0) && fixedStepSize > 0;
+    fixedStepSize = std::max(stepSize, 0.0);
+    if (reset) {
+        createIntegrator();
+    } else if (stepSize > 0) {
+        integrator->setFixedStepSize(stepSize);
+    }
+}
+
+void RolloutContext::setReportInterval(double interval, ReportMode mode) {
+    if (mode != EveryStep && !(interval > 0)) {
+        throw Exception("RolloutContext: report interval must be positive");
+    }
+    reportInterval = interval;
+    reportMode = mode;
+}
+
+void RolloutContext::setRecordedStates(const std::vector<std::string>& names) {
+    auto allNames = model.getStateVariableNames();
+    Array<std::string> labels;
+    labels.append("time");
+    recordedStates.clear();
+    for (const auto& name : names) {
+        int index = allNames.findIndex(name);
+        if (index < 0) {
+            throw Exception("RolloutContext: unknown state variable " + name);
+        }
+        recordedStates.push_back(index);
+        labels.append(name);
+    }
+    recordedValues.resize((int) recordedStates.size());
+    if (names.empty()) {
+        for (int i = 0; i < allNames.getSize(); i++) labels.append(allNames[i]);
+    }
+    states.setColumnLabels(labels);
+}
+
+void RolloutContext::setRestartTimes(const std::vector<double>& times) {
+    restartTimes = times;
+}
+
+void RolloutContext::setRestartCallback(const RestartCallback& callback) {
+    restartCallback = callback;
+}
+
+const State& RolloutContext::simulate(const State& initialState,
+                                      double finalTime, bool beginAnalyses) {
+    auto start = std::chrono::steady_clock::now();
+    // Reuse the allocations of the previous rollout.
+    workingState = initialState;
+    states.reset(0);
+    numStepsTaken = numRejectedSteps = numRealizations = 0;
+    terminated = false;
+    auto& analyses = model.updAnalysisSet();
+    if (beginAnalyses) {
+        model.getMultibodySystem().realize(workingState, Stage::Acceleration);
+        analyses.begin(workingState);
+    }
+    record(workingState);
+    setupTime = secondsSince(start);
+
+    // Each segment ends at a restart time or at the final time.
+    start = std::chrono::steady_clock::now();
+    int step = 0;
+    for (int i = 0; i <= (int) restartTimes.size(); i++) {
+        double segmentEnd = i < (int) restartTimes.size()
+                                    ? std::min(restartTimes[i], finalTime)
+                                    : finalTime;
+        if (segmentEnd <= workingState.getTime()) continue;
+        integrateSegment(segmentEnd, step);
+        workingState = integrator->getState();
+        if (terminated || segmentEnd == finalTime) break;
+        if (restartCallback) restartCallback(workingState, i);
+    }
+    analyses.end(workingState);
+    integrationTime = secondsSince(start);
+    return workingState;
+}
+
+void RolloutContext::integrateSegment(double segmentEnd, int& step) {
+    integrator->setFinalTime(segmentEnd);
+    integrator->resetAllStatistics();
+    integrator->setReturnEveryInternalStep(reportMode == EveryStep);
+    integrator->setAllowInterpolation(reportMode != Stop);
+    timeStepper->initialize(workingState);
+    if (reportMode == EveryStep) {
+        while (!integrator->isSimulationOver()) {
+            timeStepper->stepTo(segmentEnd);
+            report(integrator->getState(), step);
+        }
+    } else {
+        // The first report time after the beginning of the segment (which
+        // may be a report time of the previous segment up to round-off).
+        double k =
+                std::floor(workingState.getTime() / reportInterval + 1e-9) + 1;
+        while (!integrator->isSimulationOver()) {
+            double reportTime = k * reportInterval;
+            // A report time that differs from the end by round-off is the end.
+            if (reportTime - segmentEnd < 1e-9 * reportInterval) {
+                reportTime = std::min(reportTime, segmentEnd);
+            }
+            timeStepper->stepTo(std::min(reportTime, segmentEnd));
+            // The integrator returns early at events.
+            const auto& s = integrator->getState();
+            if (s.getTime() == reportTime) {
+                report(s, step);
+                k++;
+            }
+        }
+    }
+    terminated = integrator->getTerminationReason() !=
+                 Integrator::ReachedFinalTime;
+    numStepsTaken += integrator->getNumStepsTaken();
+    numRejectedSteps += integrator->getNumErrorTestFailures() +
+                        integrator->getNumConvergenceTestFailures();
+    numRealizations += integrator->getNumRealizations();
+}
+
+void RolloutContext::report(const State& s, int& step) {
+    model.updAnalysisSet().step(s, ++step);
+    record(s);
+}
+
+void RolloutContext::record(const State& s) {
+    if (!recordStates) return;
+    stateValues = model.getStateVariableValues(s);
+    if (!recordedStates.empty()) {
+        for (int i = 0; i < (int) recordedStates.size(); i++) {
+            recordedValues[i] = stateValues[recordedStates[i]];
+        }
+        states.append(s.getTime(), recordedValues.size(), &recordedValues[0]);
+        return;
+    }
+    states.append(s.getTime(), stateValues.size(), &stateValues[0]);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file RolloutContext.h
+ *
+ * \brief A reusable simulation context for performing many simulations
+ * (rollouts) of the same model.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef ROLLOUT_CONTEXT_H
+#define ROLLOUT_CONTEXT_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Simulation/Manager/Manager.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Keeps the integrator, time stepper and state storage of a model
+ * alive across simulations.
+ *
+ * OpenSim::Manager is meant to be constructed for each simulation, which
+ * allocates a new integrator and storages every time. A RolloutContext is
+ * created once for an initialized model and each simulate() only resets the
+ * working state, the integrator and the (optional) state storage. The
+ * analyses of the model are executed at each accepted step, as with the
+ * Manager. The wall time of the setup and the integration of the last rollout
+ * are measured separately.
+ *
+ * Optionally, the integration is stopped and restarted at given times (e.g.,
+ * the discontinuities of piecewise constant controls). Since the integrator
+ * is restarted from the state at these times, a simulation that is resumed
+ * from a stored state at a restart time produces the same trajectory as the
+ * simulation that started from the initial state.
+ *
+ * Optionally, the analyses and the state storage are executed at a fixed
+ * rate instead of at every accepted step. The samples at the report times are
+ * obtained either by stopping the integrator at these times or by
+ * interpolating the accepted steps (which does not alter the steps of the
+ * integrator). In that case, the analyses are executed only at the report
+ * times.
+ *
+ * The model must not be re-initialized while a context refers to it.
+ */
+class SimulationTools_API RolloutContext {
+ public:
+    /** Called at each restart time with the state and the index of the
+     * restart time. */
+    typedef std::function<void(const SimTK::State&, int)> RestartCallback;
+
+    /** How the analyses and the state storage are sampled. */
+    enum ReportMode {
+        /** At every accepted step of the integrator. */
+        EveryStep,
+        /** At the report times, at which the integrator is stopped. */
+        Stop,
+        /** At the report times, by interpolating the accepted steps. */
+        Interpolate
+    };
+
+    explicit RolloutContext(Model& model);
+
+    /** Integration method (Runge-Kutta-Merson by default). The accuracy and
+     * step size settings are kept. */
+    void setIntegratorMethod(Manager::IntegratorMethod method);
+    Manager::IntegratorMethod getIntegratorMethod() const { return method; }
+    /** Accuracy of the integrator. */
+    void setAccuracy(double accuracy);
+    /** Maximum step size of the integrator (zero restores the default). */
+    void setMaximumStepSize(double stepSize);
+    /** Integrate with a fixed step size (e.g., for a coarse simulation);
+     * zero restores the error controlled steps. */
+    void setFixedStepSize(double stepSize);
+    /** Record the states of each step in the state storage. */
+    void setRecordStates(bool recordStates) {
+        this->recordStates = recordStates;
+    }
+
+    /** Sample the analyses and the states every interval seconds (see
+     * ReportMode). The report times are multiples of the interval. */
+    void setReportInterval(double interval, ReportMode mode = Interpolate);
+    /** Record only the given state variables (all if empty). */
+    void setRecordedStates(const std::vector<std::string>& names);
+
+    /** Times (ascending) at which the integration is stopped and
+     * restarted. */
+    void setRestartTimes(const std::vector<double>& times);
+    void setRestartCallback(const RestartCallback& callback);
+
+    /** Simulates the model from the initial state to the final time (or until
+     * an event terminates the simulation) and returns the final state. When
+     * a simulation is resumed from an intermediate state, beginAnalyses must
+     * be false and the analyses must be restored by the caller. */
+    const SimTK::State& simulate(const SimTK::State& initialState,
+                                 double finalTime, bool beginAnalyses = true);
+    /** True if the last simulation was terminated by an event. */
+    bool isTerminated() const { return terminated; }
+    /** Integrator statistics of the last simulation (over all segments). */
+    int getNumStepsTaken() const { return numStepsTaken; }
+    int getNumRejectedSteps() const { return numRejectedSteps; }
+    int getNumRealizations() const { return numRealizations; }
+
+    const Model& getModel() const { return model; }
+    const SimTK::Integrator& getIntegrator() const { return *integrator; }
+    /** States of the last rollout (if recorded). */
+    const Storage& getStateStorage() const { return states; }
+    /** Wall time (s) spent to reset the context in the last rollout. */
+    double getSetupTime() const { return setupTime; }
+    /** Wall time (s) spent in the integration of the last rollout. */
+    double getIntegrationTime() const { return integrationTime; }
+
+ private:
+    void createIntegrator();
+    void record(const SimTK::State& s);
+    // Executes the analyses and records the state of an accepted step or a
+    // report time.
+    void report(const SimTK::State& s, int& step);
+    // Integrates from the integrator's current state to the final time of
+    // the segment.
+    void integrateSegment(double segmentEnd, int& step);
+
+    Model& model;
+    std::unique_ptr<SimTK::Integrator> integrator;
+    std::unique_ptr<SimTK::TimeStepper> timeStepper;
+    Manager::IntegratorMethod method =
+            Manager::IntegratorMethod::RungeKuttaMerson;
+    // Zero keeps the default of the integrator.
+    double accuracy = 0;
+    double maximumStepSize = 0;
+    double fixedStepSize = 0;
+    SimTK::State workingState;
+    Storage states;
+    SimTK::Vector stateValues;
+    std::vector<double> restartTimes;
+    RestartCallback restartCallback;
+    bool recordStates = true;
+    // Indices of the recorded state variables (empty for all).
+    std::vector<int> recordedStates;
+    SimTK::Vector recordedValues;
+    double reportInterval = 0;
+    ReportMode reportMode = EveryStep;
+    bool terminated = false;
+    int numStepsTaken = 0;
+    int numRejectedSteps = 0;
+    int numRealizations = 0;
+    double setupTime = 0;
+    double integrationTime = 0;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,16 @@
+/**
+ * @file SimulationToolsExports.h
+ *
+ * \brief Definitions for dll exports on Windows.
+ *
+ * @author agent <agent@local>
+ */
+#ifdef WIN32
+#    ifdef SimulationTools_EXPORTS
+#        define SimulationTools_API __declspec(dllexport)
+#    else
+#        define SimulationTools_API __declspec(dllimport)
+#    endif
+#else
+#    define SimulationTools_API
+#endif // WIN32
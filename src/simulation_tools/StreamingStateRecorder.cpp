@@ -0,0 +1,76 @@
+#include "StreamingStateRecorder.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+StreamingStateRecorder::StreamingStateRecorder() : Analysis() {
+    constructProperties();
+}
+
+StreamingStateRecorder::StreamingStateRecorder(const std::string& fileName,
+                                               int chunkSize, int maxChunks)
+        : Analysis() {
+    constructProperties();
+    set_file_name(fileName);
+    set_chunk_size(chunkSize);
+    set_max_chunks(maxChunks);
+    setName("StreamingStateRecorder");
+}
+
+void StreamingStateRecorder::constructProperties() {
+    constructProperty_file_name("states.sto");
+    constructProperty_chunk_size(1000);
+    constructProperty_max_chunks(4);
+}
+
+long long StreamingStateRecorder::getNumRows() const {
+    return writer ? writer->getNumRows() : 0;
+}
+
+int StreamingStateRecorder::getNumStalls() const {
+    return writer ? writer->getNumStalls() : 0;
+}
+
+std::size_t StreamingStateRecorder::getMemoryBudget() const {
+    return writer ? writer->getMemoryBudget() : 0;
+}
+
+void StreamingStateRecorder::record(const State& s) {
+    Vector values = _model->getStateVariableValues(s);
+    writer->append(s.getTime(), &values[0]);
+    lastTime = s.getTime();
+}
+
+int StreamingStateRecorder::begin(const State& s) {
+    if (!proceed()) return 0;
+    std::vector<std::string> labels{"time"};
+    auto names = _model->getStateVariableNames();
+    for (int i = 0; i < names.getSize(); i++) labels.push_back(names[i]);
+    const auto& fileName = get_file_name();
+    bool binary = fileName.size() >= 4 &&
+                  fileName.compare(fileName.size() - 4, 4, ".osb") == 0;
+    writer.reset();  // closes the file of the previous simulation
+    writer = std::make_shared<StreamingStorageWriter>(
+            fileName, _model->getName() + "_states", labels,
+            get_chunk_size(), get_max_chunks(), false,
+            binary ? StreamingStorageWriter::Binary
+                   : StreamingStorageWriter::Text);
+    record(s);
+    return 0;
+}
+
+int StreamingStateRecorder::step(const State& s, int stepNumber) {
+    if (!proceed(stepNumber) || !writer) return 0;
+    record(s);
+    return 0;
+}
+
+int StreamingStateRecorder::end(const State& s) {
+    if (!proceed() || !writer) return 0;
+    // The last step may already have been recorded.
+    if (s.getTime() != lastTime) record(s);
+    writer->close();
+    return 0;
+}
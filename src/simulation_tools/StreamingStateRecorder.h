@@ -0,0 +1,67 @@
+/**
+ * @file StreamingStateRecorder.h
+ *
+ * \brief An analysis that streams the states to a file during the simulation
+ * instead of keeping them in memory.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef STREAMING_STATE_RECORDER_H
+#define STREAMING_STATE_RECORDER_H
+
+#include "SimulationToolsExports.h"
+#include "StreamingStorageWriter.h"
+
+#include <OpenSim/Simulation/Model/Analysis.h>
+#include <memory>
+
+namespace OpenSim {
+/**
+ * \brief Records the state variables at each accepted step into a .sto file,
+ * or a binary storage file if the file name ends with .osb, with a fixed
+ * memory budget (see StreamingStorageWriter).
+ *
+ * This replaces the state storage of the Manager for long simulations or
+ * large models, whose trajectory does not fit in memory; disable the storage
+ * of the Manager (Manager::setWriteToStorage(false)) when using it. The file
+ * is complete after end() is called (i.e., when the integration finishes).
+ */
+class SimulationTools_API StreamingStateRecorder : public Analysis {
+    OpenSim_DECLARE_CONCRETE_OBJECT(StreamingStateRecorder, Analysis);
+
+ public:
+    OpenSim_DECLARE_PROPERTY(file_name, std::string,
+                             "File (.sto or .osb) to which the states are "
+                             "written.");
+    OpenSim_DECLARE_PROPERTY(chunk_size, int,
+                             "Number of rows that are written at once.");
+    OpenSim_DECLARE_PROPERTY(max_chunks, int,
+                             "Maximum number of chunks in memory (at least "
+                             "2).");
+
+    StreamingStateRecorder();
+    StreamingStateRecorder(const std::string& fileName, int chunkSize = 1000,
+                           int maxChunks = 4);
+
+    /** Number of rows that were recorded in the last simulation. */
+    long long getNumRows() const;
+    /** Number of times that the simulation waited for the disk. */
+    int getNumStalls() const;
+    /** Upper bound of the memory used by the recorder (bytes). */
+    std::size_t getMemoryBudget() const;
+
+    int begin(const SimTK::State& s) override;
+    int step(const SimTK::State& s, int stepNumber) override;
+    int end(const SimTK::State& s) override;
+
+ private:
+    void constructProperties();
+    void record(const SimTK::State& s);
+
+    // Shared, because Objects must be copyable; begin() creates a new writer.
+    std::shared_ptr<StreamingStorageWriter> writer;
+    double lastTime = SimTK::NaN;
+};
+} // namespace OpenSim
+
+#endif
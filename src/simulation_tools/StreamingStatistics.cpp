@@ -0,0 +1,137 @@
+#include "StreamingStatistics.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace OpenSim;
+
+namespace {
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+}
+
+void RunningMoments::add(double value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    if (count == 1) {
+        min = max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+}
+
+void RunningMoments::merge(const RunningMoments& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    long long total = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    m2 += other.m2 + delta * delta * count * other.count / total;
+    count = total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double RunningMoments::getMean() const { return count > 0 ? mean : NaN; }
+
+double RunningMoments::getVariance() const {
+    return count > 1 ? m2 / (count - 1) : NaN;
+}
+
+double RunningMoments::getStandardDeviation() const {
+    return std::sqrt(getVariance());
+}
+
+double RunningMoments::getMin() const { return count > 0 ? min : NaN; }
+
+double RunningMoments::getMax() const { return count > 0 ? max : NaN; }
+
+P2Quantile::P2Quantile(double p) : p(p) {
+    if (!(p > 0 && p < 1)) {
+        throw Exception("P2Quantile: probability must be in (0, 1)");
+    }
+    const double initialDesired[5] = {0, 2 * p, 4 * p, 2 + 2 * p, 4};
+    const double initialIncrements[5] = {0, p / 2, p, (1 + p) / 2, 1};
+    for (int i = 0; i < 5; i++) {
+        heights[i] = 0;
+        positions[i] = i;
+        desired[i] = initialDesired[i];
+        increments[i] = initialIncrements[i];
+    }
+}
+
+void P2Quantile::add(double value) {
+    // The first five values initialize the markers.
+    if (count < 5) {
+        heights[count++] = value;
+        std::sort(heights, heights + count);
+        return;
+    }
+    count++;
+
+    // Find the cell of the value and extend the extreme markers.
+    int k;
+    if (value < heights[0]) {
+        heights[0] = value;
+        k = 0;
+    } else if (value >= heights[4]) {
+        heights[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while (value >= heights[k + 1]) k++;
+    }
+    for (int i = k + 1; i < 5; i++) positions[i]++;
+    for (int i = 0; i < 5; i++) desired[i] += increments[i];
+
+    // Move the middle markers towards their desired positions.
+    for (int i = 1; i < 4; i++) {
+        double offset = desired[i] - positions[i];
+        if ((offset >= 1 && positions[i + 1] - positions[i] > 1) ||
+            (offset <= -1 && positions[i - 1] - positions[i] < -1)) {
+            int d = offset > 0 ? 1 : -1;
+            double height = parabolic(i, d);
+            if (heights[i - 1] < height && height < heights[i + 1]) {
+                heights[i] = height;
+            } else {
+                heights[i] = linear(i, d);
+            }
+            positions[i] += d;
+        }
+    }
+}
+
+double P2Quantile::parabolic(int i, int d) const {
+    return heights[i] +
+           d / (positions[i + 1] - positions[i - 1]) *
+                   ((positions[i] - positions[i - 1] + d) *
+                            (heights[i + 1] - heights[i]) /
+                            (positions[i + 1] - positions[i]) +
+                    (positions[i + 1] - positions[i] - d) *
+                            (heights[i] - heights[i - 1]) /
+                            (positions[i] - positions[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const {
+    return heights[i] + d * (heights[i + d] - heights[i]) /
+                                (positions[i + d] - positions[i]);
+}
+
+double P2Quantile::getValue() const {
+    if (count == 0) return NaN;
+    if (count <= 5) {
+        // exact quantile of the sorted values (linear interpolation)
+        double position = p * (count - 1);
+        int i = int(position);
+        if (i + 1 >= count) return heights[count - 1];
+        return heights[i] + (position - i) * (heights[i + 1] - heights[i]);
+    }
+    return heights[2];
+}
@@ -0,0 +1,80 @@
+/**
+ * @file StreamingStatistics.h
+ *
+ * \brief Statistics of a stream of values that are updated one value at a time
+ * with constant memory.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef STREAMING_STATISTICS_H
+#define STREAMING_STATISTICS_H
+
+#include "SimulationToolsExports.h"
+
+namespace OpenSim {
+/**
+ * \brief Count, mean, variance and range of a stream (Welford's algorithm),
+ * which is numerically stable for long streams. Partial accumulators (e.g.,
+ * of different threads) are combined with merge().
+ */
+class SimulationTools_API RunningMoments {
+ public:
+    void add(double value);
+    /** Combines the statistics of another stream (Chan et al.). */
+    void merge(const RunningMoments& other);
+
+    long long getCount() const { return count; }
+    /** NaN if empty. */
+    double getMean() const;
+    /** Unbiased sample variance (NaN for less than two values). */
+    double getVariance() const;
+    double getStandardDeviation() const;
+    double getMin() const;
+    double getMax() const;
+
+ private:
+    long long count = 0;
+    double mean = 0;
+    // sum of the squared deviations from the mean
+    double m2 = 0;
+    double min = 0;
+    double max = 0;
+};
+
+/**
+ * \brief Streaming estimate of a quantile with five markers (the P^2
+ * algorithm of Jain and Chlamtac, 1985).
+ *
+ * The estimate is exact for up to five values; afterwards the markers are
+ * adjusted by piecewise parabolic interpolation, so that the memory does not
+ * depend on the number of values. The estimate depends on the order of the
+ * values, but converges for stationary streams.
+ */
+class SimulationTools_API P2Quantile {
+ public:
+    /** Estimates the quantile of the probability p in (0, 1). */
+    explicit P2Quantile(double p);
+
+    void add(double value);
+
+    double getProbability() const { return p; }
+    long long getCount() const { return count; }
+    /** NaN if empty. */
+    double getValue() const;
+
+ private:
+    double parabolic(int i, int d) const;
+    double linear(int i, int d) const;
+
+    double p;
+    long long count = 0;
+    // marker heights, actual and desired positions and the increments of
+    // the desired positions
+    double heights[5];
+    double positions[5];
+    double desired[5];
+    double increments[5];
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,210 @@
+#include "StreamingStorageWriter.h"
+
+#include "BinaryStorage.h"
+
+#include <OpenSim/Common/Exception.h>
+#include <algorithm>
+#include <fstream>
+
+using namespace OpenSim;
+using namespace std;
+
+namespace {
+// Seeks from the beginning of a file that may exceed 2 GB, where long is 32
+// bits (e.g., Windows).
+int seek(FILE* file, long long offset) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET);
+#else
+    return fseeko(file, off_t(offset), SEEK_SET);
+#endif
+}
+} // namespace
+
+StreamingStorageWriter::StreamingStorageWriter(const string& fileName,
+                                               const string& name,
+                                               const vector<string>& labels,
+                                               int chunkSize, int maxChunks,
+                                               bool inDegrees, Format format)
+        : format(format), fileName(fileName), name(name), labels(labels),
+          inDegrees(inDegrees), numColumns(int(labels.size())),
+          chunkSize(max(chunkSize, 1)), maxChunks(max(maxChunks, 2)) {
+    if (numColumns == 0) {
+        throw Exception("StreamingStorageWriter: no column labels");
+    }
+    if (format == Binary) {
+        // The columns are written to the binary file when it is closed.
+        file = fopen((fileName + ".tmp").c_str(), "w+b");
+        if (!file) {
+            throw Exception("StreamingStorageWriter: cannot write " +
+                            fileName + ".tmp");
+        }
+        column.reserve(size_t(this->chunkSize));
+    } else {
+        file = fopen(fileName.c_str(), "w");
+        if (!file) {
+            throw Exception("StreamingStorageWriter: cannot write " +
+                            fileName);
+        }
+        fprintf(file, "%s\nversion=1\nnRows=", name.c_str());
+        // The number of rows is not known yet, thus, space is reserved.
+        nRowsPosition = ftell(file);
+        fprintf(file, "%-20d\nnColumns=%d\ninDegrees=%s\nendheader\n", 0,
+                numColumns, inDegrees ? "yes" : "no");
+        for (int j = 0; j < numColumns; ++j) {
+            fprintf(file, j == 0 ? "%s" : "\t%s", labels[j].c_str());
+        }
+        fprintf(file, "\n");
+    }
+
+    current.reserve(size_t(this->chunkSize) * numColumns);
+    numAllocated = 1;
+    worker = thread(&StreamingStorageWriter::run, this);
+}
+
+StreamingStorageWriter::~StreamingStorageWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; call close() to observe errors.
+    }
+}
+
+void StreamingStorageWriter::append(double time, const double* values) {
+    if (closed) throw Exception("StreamingStorageWriter: file is closed");
+    current.push_back(time);
+    current.insert(current.end(), values, values + numColumns - 1);
+    numRows++;
+    if (current.size() == size_t(chunkSize) * numColumns) {
+        submitCurrentChunk();
+    }
+}
+
+void StreamingStorageWriter::submitCurrentChunk() {
+    unique_lock<std::mutex> lock(mutex);
+    // an error of an earlier chunk is reported before any return
+    if (!error.empty()) throw Exception("StreamingStorageWriter: " + error);
+    pending.push_back(std::move(current));
+    hasWork.notify_one();
+    if (reusable.empty() && numAllocated < maxChunks) {
+        numAllocated++;
+        current = Chunk();
+        current.reserve(size_t(chunkSize) * numColumns);
+        return;
+    }
+    if (reusable.empty()) {
+        numStalls++;
+        hasSpace.wait(lock, [this]() { return !reusable.empty(); });
+    }
+    current = std::move(reusable.back());
+    reusable.pop_back();
+    if (!error.empty()) throw Exception("StreamingStorageWriter: " + error);
+}
+
+void StreamingStorageWriter::close() {
+    if (closed) return;
+    closed = true;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (!current.empty()) pending.push_back(std::move(current));
+        stop = true;
+    }
+    hasWork.notify_one();
+    worker.join();
+
+    if (format == Binary) {
+        if (error.empty()) writeBinaryFile();
+        fclose(file);
+        remove((fileName + ".tmp").c_str());
+    } else {
+        seek(file, nRowsPosition);
+        fprintf(file, "%-20lld", numRows);
+        if (fclose(file) != 0 && error.empty()) {
+            error = "cannot close the file";
+        }
+    }
+    file = nullptr;
+    if (!error.empty()) throw Exception("StreamingStorageWriter: " + error);
+}
+
+void StreamingStorageWriter::writeBinaryFile() {
+    ofstream binary(fileName, ios::binary);
+    if (!binary) {
+        error = "cannot write " + fileName;
+        return;
+    }
+    BinaryStorage::writeHeader(binary, name, inDegrees, uint64_t(numRows),
+                               labels);
+    // Column j of a chunk of n rows starts at j * n values after the
+    // beginning of the chunk.
+    for (int j = 0; j < numColumns && error.empty(); ++j) {
+        long long chunkBegin = 0;
+        for (auto rows : chunkRows) {
+            column.resize(size_t(rows));
+            long long offset = (chunkBegin + j * rows) * sizeof(double);
+            if (seek(file, offset) != 0 ||
+                fread(column.data(), sizeof(double), column.size(), file) !=
+                        column.size()) {
+                error = "cannot read " + fileName + ".tmp";
+                break;
+            }
+            binary.write(reinterpret_cast<const char*>(column.data()),
+                         column.size() * sizeof(double));
+            chunkBegin += rows * numColumns;
+        }
+    }
+    binary.close();
+    if (!binary && error.empty()) error = "cannot write " + fileName;
+}
+
+size_t StreamingStorageWriter::getMemoryBudget() const {
+    return size_t(maxChunks) * chunkSize * numColumns * sizeof(double);
+}
+
+void StreamingStorageWriter::run() {
+    unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        hasWork.wait(lock, [this]() { return stop || !pending.empty(); });
+        if (pending.empty()) break;
+        Chunk chunk = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        writeChunk(chunk);
+        lock.lock();
+        chunk.clear();
+        reusable.push_back(std::move(chunk));
+        hasSpace.notify_one();
+    }
+}
+
+void StreamingStorageWriter::writeChunk(const Chunk& chunk) {
+    if (format == Binary) {
+        writeBinaryChunk(chunk);
+        return;
+    }
+    for (size_t k = 0; k < chunk.size(); ++k) {
+        fprintf(file, k % numColumns == 0 ? "%.17g" : "\t%.17g", chunk[k]);
+        if (k % numColumns == size_t(numColumns) - 1) fputc('\n', file);
+    }
+    if (ferror(file)) {
+        lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) error = "cannot write the file";
+    }
+}
+
+void StreamingStorageWriter::writeBinaryChunk(const Chunk& chunk) {
+    // The rows of the chunk are transposed into columns.
+    size_t rows = chunk.size() / numColumns;
+    for (int j = 0; j < numColumns; ++j) {
+        column.clear();
+        for (size_t i = 0; i < rows; ++i) {
+            column.push_back(chunk[i * numColumns + j]);
+        }
+        fwrite(column.data(), sizeof(double), rows, file);
+    }
+    chunkRows.push_back((long long) rows);
+    if (ferror(file)) {
+        lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) error = "cannot write the file";
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file StreamingStorageWriter.h
+ *
+ * \brief Writes rows of a time series to a .sto or binary storage file on a
+ * background thread while they are produced, using a fixed amount of memory.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef STREAMING_STORAGE_WRITER_H
+#define STREAMING_STORAGE_WRITER_H
+
+#include "SimulationToolsExports.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenSim {
+/**
+ * \brief Streams rows to a .sto or binary storage (.osb) file in chunks.
+ *
+ * Rows are appended to the current chunk. A full chunk is handed to a
+ * background thread, which formats and writes it, and the buffer of the chunk
+ * is reused afterwards. At most maxChunks chunks are in memory; if the writer
+ * falls behind, append() blocks until a chunk has been written (a stall).
+ * Therefore, the memory does not grow with the length of the simulation.
+ *
+ * The number of rows in the header is written when the file is closed. The
+ * values are printed with 17 significant digits (i.e., without loss).
+ *
+ * A binary file (see BinaryStorage) is columnar, thus, it cannot be written
+ * row by row. Each chunk is written by columns to a temporary file (the file
+ * name followed by .tmp), which is copied column by column into the file when
+ * it is closed. The values are not formatted and the memory stays bounded.
+ */
+class SimulationTools_API StreamingStorageWriter {
+ public:
+    enum Format { Text, Binary };
+
+    /** The labels include time (first column). */
+    StreamingStorageWriter(const std::string& fileName,
+                           const std::string& name,
+                           const std::vector<std::string>& labels,
+                           int chunkSize = 1000, int maxChunks = 4,
+                           bool inDegrees = false, Format format = Text);
+    /** Closes the file, if not closed already. */
+    ~StreamingStorageWriter();
+    StreamingStorageWriter(const StreamingStorageWriter&) = delete;
+    StreamingStorageWriter& operator=(const StreamingStorageWriter&) = delete;
+
+    /** Appends a row with labels.size() - 1 values. */
+    void append(double time, const double* values);
+    /** Writes the pending rows, updates the header and closes the file. */
+    void close();
+
+    /** Number of appended rows. */
+    long long getNumRows() const { return numRows; }
+    /** Number of times that append() waited for the background thread. */
+    int getNumStalls() const { return numStalls; }
+    /** Upper bound of the memory used by the chunks (bytes). */
+    std::size_t getMemoryBudget() const;
+
+ private:
+    typedef std::vector<double> Chunk;
+    void run();
+    void submitCurrentChunk();
+    void writeChunk(const Chunk& chunk);
+    void writeBinaryChunk(const Chunk& chunk);
+    // Copies the columns of the temporary file into the binary file.
+    void writeBinaryFile();
+
+    std::FILE* file = nullptr;
+    long nRowsPosition = 0;
+    Format format;
+    // The header of a binary file is written when it is closed.
+    std::string fileName, name;
+    std::vector<std::string> labels;
+    bool inDegrees;
+    // Number of rows of each chunk in the temporary file (binary format).
+    std::vector<long long> chunkRows;
+    std::vector<double> column;
+    int numColumns;
+    int chunkSize;
+    int maxChunks;
+    long long numRows = 0;
+    int numStalls = 0;
+    bool closed = false;
+    Chunk current;
+    std::deque<Chunk> pending;   // waiting to be written
+    std::vector<Chunk> reusable; // buffers to be reused
+    int numAllocated = 0;
+    bool stop = false;
+    std::string error;
+    std::mutex mutex;
+    std::condition_variable hasWork, hasSpace;
+    // Declared last, so that it is started after the members are initialized.
+    std::thread worker;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,66 @@
+#include "TerminationEvent.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenSim;
+using namespace SimTK;
+
+TerminationEvent::TerminationEvent(const Signal& signal, Stage stage,
+                                   bool onRising, bool onFalling,
+                                   const Condition& armed)
+        : TriggeredEventHandler(stage), signal(signal), armed(armed) {
+    getTriggerInfo().setTriggerOnRisingSignTransition(onRising);
+    getTriggerInfo().setTriggerOnFallingSignTransition(onFalling);
+}
+
+Real TerminationEvent::getValue(const State& s) const { return signal(s); }
+
+void TerminationEvent::handleEvent(State& s, Real accuracy,
+                                   bool& shouldTerminate) const {
+    if (!armed || armed(s)) shouldTerminate = true;
+}
+
+TerminationEvent* TerminationEvent::addToModel(Model& model,
+                                               TerminationEvent* event) {
+    model.updMultibodySystem().addEventHandler(event);
+    return event;
+}
+
+TerminationEvent::Condition
+TerminationEvent::isAirborne(const Model& model, const std::string& force,
+                             double threshold) {
+    const Force* contact = &model.getForceSet().get(force);
+    return [contact, threshold](const State& s) {
+        auto values = contact->getRecordValues(s);
+        double sum = 0;
+        for (int i = 0; i < values.getSize(); i++) sum += std::abs(values[i]);
+        return sum < threshold;
+    };
+}
+
+TerminationEvent*
+TerminationEvent::createApexEvent(const Model& model, const Condition& armed) {
+    const Model* m = &model;
+    return new TerminationEvent(
+            [m](const State& s) { return m->calcMassCenterVelocity(s)[1]; },
+            Stage::Dynamics, false, true, armed);
+}
+
+TerminationEvent* TerminationEvent::createBallisticBoundEvent(
+        const Model& model, const Condition& armed, const double* threshold) {
+    const Model* m = &model;
+    // While armed, the signal is the margin of the reachable height over the
+    // threshold. Otherwise, a positive constant is returned, thus, a falling
+    // transition is also detected when the event becomes armed with a
+    // negative margin.
+    return new TerminationEvent(
+            [m, armed, threshold](const State& s) {
+                if (armed && !armed(s)) return 1.0;
+                double g = -m->getGravity()[1];
+                double y = m->calcMassCenterPosition(s)[1];
+                double v = std::max(0.0, m->calcMassCenterVelocity(s)[1]);
+                return y + v * v / (2 * g) - *threshold;
+            },
+            Stage::Dynamics, false, true, armed);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file TerminationEvent.h
+ *
+ * \brief Event handlers that terminate the numerical integration early.
+ *
+ * @author agent <agent@local>
+ */
+#ifndef TERMINATION_EVENT_H
+#define TERMINATION_EVENT_H
+
+#include "SimulationToolsExports.h"
+
+#include <OpenSim/Simulation/Model/Model.h>
+#include <functional>
+
+namespace OpenSim {
+/**
+ * \brief Terminates the integration when a signal crosses zero.
+ *
+ * The event is localized by the integrator at the zero crossing of the signal,
+ * in the direction(s) of interest. The integration is terminated only if the
+ * event is armed at that time, otherwise the event is ignored. The event must
+ * be added to the system after Model::buildSystem() and before
+ * Model::initializeState() (see addToModel()).
+ */
+class SimulationTools_API TerminationEvent
+        : public SimTK::TriggeredEventHandler {
+ public:
+    typedef std::function<double(const SimTK::State&)> Signal;
+    typedef std::function<bool(const SimTK::State&)> Condition;
+
+    TerminationEvent(const Signal& signal, SimTK::Stage stage,
+                     bool onRising, bool onFalling,
+                     const Condition& armed = Condition());
+
+    SimTK::Real getValue(const SimTK::State& s) const override;
+    void handleEvent(SimTK::State& s, SimTK::Real accuracy,
+                     bool& shouldTerminate) const override;
+
+    /** Adds the event to the system of the model. The system takes
+     * ownership. */
+    static TerminationEvent* addToModel(Model& model, TerminationEvent* event);
+
+    /** True when the sum of the absolute record values (forces and torques)
+     * of the given (contact) force is below the threshold, i.e., the model is
+     * airborne. */
+    static Condition isAirborne(const Model& model, const std::string& force,
+                                double threshold = 1e-3);
+
+    /** Terminates when the vertical velocity of the model's center of mass
+     * crosses zero downwards (apex of a jump) while the armed condition is
+     * true (e.g., after liftoff). */
+    static TerminationEvent* createApexEvent(const Model& model,
+                                             const Condition& armed);
+
+    /** Terminates when the maximum height that the center of mass can reach
+     * by ballistic motion drops below the threshold while the armed
+     * condition is true. This is used to stop rollouts whose jump height
+     * cannot improve on the incumbent. The bound holds for the current
+     * flight only, thus, the armed condition must exclude a later flight
+     * (e.g., no force can launch the model again) or the rollout must end at
+     * the apex (see createApexEvent). The threshold is read through the
+     * pointer, so that the caller can update it between simulations. */
+    static TerminationEvent*
+    createBallisticBoundEvent(const Model& model, const Condition& armed,
+                              const double* threshold);
+
+ private:
+    Signal signal;
+    Condition armed;
+};
+} // namespace OpenSim
+
+#endif
@@ -0,0 +1,740 @@
+/**
+ * @file TestSimulationTools.cpp
+ *
+ * \brief Tests the utilities of the SimulationTools library.
+ *
+ * @author agent <agent@local>
+ */
+#include "AsyncWriter.h"
+#include "BinaryStorage.h"
+#include "ControlBasisFunction.h"
+#include "ControlSwitchEvent.h"
+#include "EnsembleRunner.h"
+#include "EvaluationCache.h"
+#include "FiniteDifferenceGradient.h"
+#include "IntegratorTuner.h"
+#include "LatestValue.h"
+#include "ModelSnapshot.h"
+#include "MonteCarloCampaign.h"
+#include "OptimizationCheckpoint.h"
+#include "OutputReducer.h"
+#include "PrefixStateCache.h"
+#include "RolloutContext.h"
+#include "StreamingStateRecorder.h"
+#include "TerminationEvent.h"
+
+#include <OpenSim/OpenSim.h>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+
+#define PAUSE                                                                  \
+    cout << endl << "press a key to continue ..." << endl;                     \
+    getchar();
+
+void assertEqual(double actual, double expected, double tolerance,
+                 const string& message) {
+    if (abs(actual - expected) > tolerance) {
+        throw Exception(message + ": expected " + to_string(expected) +
+                        " got " + to_string(actual));
+    }
+}
+
+// A body that moves freely along the vertical axis from height h0 with initial
+// velocity v0.
+Model createFallingBody(double h0, double v0 = 0) {
+    Model model;
+    model.setName("falling_body");
+    model.setGravity(Vec3(0, -9.81, 0));
+    auto body = new OpenSim::Body("body", 1.0, Vec3(0), Inertia(1));
+    auto joint = new SliderJoint("slider", model.getGround(), Vec3(0),
+                                 Vec3(0, 0, Pi / 2), *body, Vec3(0),
+                                 Vec3(0, 0, Pi / 2));
+    joint->updCoordinate().setName("height");
+    joint->updCoordinate().setDefaultValue(h0);
+    joint->updCoordinate().setDefaultSpeedValue(v0);
+    model.addBody(body);
+    model.addJoint(joint);
+    return model;
+}
+
+void testOutputReducer() {
+    double h0 = 2, tf = 0.5, g = 9.81;
+    auto model = createFallingBody(h0);
+    auto maxHeight = new OutputReducer("", "com_position", "max", 1);
+    auto minHeight = new OutputReducer("", "com_position", "min", 1);
+    auto integral = new OutputReducer("", "com_position", "integral", 1);
+    auto finalHeight = new OutputReducer("", "com_position", "final", 1);
+    model.addAnalysis(maxHeight);
+    model.addAnalysis(minHeight);
+    model.addAnalysis(integral);
+    model.addAnalysis(finalHeight);
+
+    auto state = model.initSystem();
+    Manager manager(model);
+    manager.setIntegratorMaximumStepSize(0.001);
+    manager.initialize(state);
+    manager.integrate(tf);
+
+    double hf = h0 - 0.5 * g * tf * tf;
+    assertEqual(maxHeight->getValue(), h0, 1e-6, "max");
+    assertEqual(minHeight->getValue(), hf, 1e-6, "min");
+    assertEqual(finalHeight->getValue(), hf, 1e-6, "final");
+    assertEqual(integral->getValue(), h0 * tf - g * pow(tf, 3) / 6, 1e-4,
+                "integral");
+    cout << "OutputReducer: ok" << endl;
+}
+
+void testApexTermination() {
+    double h0 = 1, v0 = 2, g = 9.81;
+    auto model = createFallingBody(h0, v0);
+    model.buildSystem();
+    TerminationEvent::addToModel(
+            model, TerminationEvent::createApexEvent(
+                           model, TerminationEvent::Condition()));
+    auto state = model.initializeState();
+    Manager manager(model);
+    manager.initialize(state);
+    state = manager.integrate(2);
+
+    assertEqual(state.getTime(), v0 / g, 1e-3, "apex time");
+    assertEqual(model.calcMassCenterPosition(state)[1],
+                h0 + v0 * v0 / (2 * g), 1e-4, "apex height");
+    cout << "TerminationEvent: ok" << endl;
+}
+
+void testBallisticBoundWithTwoHops() {
+    // two launches by a thrust: the first flight reaches h1 and the second
+    // h2 > h1, the thrust is zero (airborne) in [0.1, 0.5) and after 0.6
+    double h0 = 1, g = 9.81;
+    auto model = createFallingBody(h0);
+    auto thrust = new CoordinateActuator("height");
+    thrust->setName("thrust");
+    thrust->setOptimalForce(1);
+    model.addForce(thrust);
+    auto controller = new PrescribedController();
+    controller->addActuator(*thrust);
+    double t[4] = {0.0, 0.1, 0.5, 0.6}, x[4] = {3 * g, 0.0, 6 * g, 0.0};
+    controller->prescribeControlForActuator(
+            "thrust", new PiecewiseConstantFunction(4, t, x));
+    model.addController(controller);
+    auto maxHeight = new OutputReducer("", "com_position", "max", 1);
+    model.addAnalysis(maxHeight);
+
+    // the states at the ends of the pulses
+    double v1 = 2 * g * 0.1, y1 = h0 + g * 0.1 * 0.1;
+    double h1 = y1 + v1 * v1 / (2 * g);
+    double v2 = -v1 + 5 * g * 0.1, y2 = y1 - v1 * 0.1 + 2.5 * g * 0.1 * 0.1;
+    double h2 = y2 + v2 * v2 / (2 * g);
+
+    // the bound is armed only in the last flight
+    double threshold = (h1 + h2) / 2;
+    model.buildSystem();
+    ControlSwitchEvent::addToModel(model);
+    TerminationEvent::addToModel(
+            model, TerminationEvent::createBallisticBoundEvent(
+                           model,
+                           [](const State& s) { return s.getTime() >= 0.6; },
+                           &threshold));
+    auto state = model.initializeState();
+    RolloutContext context(model);
+    context.setAccuracy(1e-6);
+
+    // the first flight is below the threshold, but the bound must not fire
+    context.simulate(state, 1.0);
+    if (context.isTerminated()) throw Exception("first flight was bounded");
+    assertEqual(maxHeight->getValue(), h2, 1e-4, "second apex");
+
+    // the last flight cannot reach this threshold
+    threshold = h2 + 0.1;
+    context.simulate(state, 1.0);
+    if (!context.isTerminated()) throw Exception("last flight not bounded");
+    assertEqual(context.getIntegrator().getState().getTime(), 0.6, 1e-3,
+                "termination time");
+    cout << "TerminationEvent ballistic bound: ok" << endl;
+}
+
+void testEvaluationCache() {
+    string fileName = "test_evaluation_cache.txt";
+    remove(fileName.c_str());
+    {
+        EvaluationCache cache(1e-6, 2, fileName, "test");
+        double value;
+        Vector x(3, 0.5), y(3, 0.25), z(3, 0.125);
+        if (cache.lookup(x, value)) throw Exception("unexpected hit");
+        cache.insert(x, 1);
+        cache.insert(y, 2);
+        // equal within tolerance
+        if (!cache.lookup(x + 1e-9, value) || value != 1) {
+            throw Exception("expected hit");
+        }
+        // y is the least recently used and is evicted
+        cache.insert(z, 3);
+        if (cache.lookup(y, value)) throw Exception("expected eviction");
+        if (cache.getNumHits() != 1 || cache.getNumMisses() != 2) {
+            throw Exception("wrong hit/miss counters");
+        }
+    }
+    // entries are restored from the file
+    {
+        EvaluationCache cache(1e-6, 10, fileName, "test");
+        if (cache.getSize() != 3) throw Exception("cache file not loaded");
+    }
+    // the truncated entry of a killed run is ignored and new entries are
+    // appended after it
+    {
+        ofstream(fileName, ios::app) << "3 1 2";
+        EvaluationCache cache(1e-6, 10, fileName, "test");
+        if (cache.getSize() != 3) throw Exception("truncated entry loaded");
+        cache.insert(Vector(3, 0.75), 4);
+        // parameters outside of the grid are not cached
+        double value;
+        cache.insert(Vector(3, Infinity), 5);
+        cache.insert(Vector(3, 1e300), 6);
+        if (cache.lookup(Vector(3, Infinity), value) ||
+            cache.lookup(Vector(3, 1e300), value)) {
+            throw Exception("parameters outside of the grid were cached");
+        }
+    }
+    {
+        EvaluationCache cache(1e-6, 10, fileName, "test");
+        double value;
+        if (cache.getSize() != 4 || !cache.lookup(Vector(3, 0.75), value) ||
+            value != 4) {
+            throw Exception("entry after a truncated entry not loaded");
+        }
+    }
+    // the file of a different study is ignored
+    EvaluationCache cache(1e-6, 10, fileName, "other");
+    if (cache.getSize() != 0) throw Exception("stale cache file loaded");
+    cout << "EvaluationCache: ok" << endl;
+}
+
+void testFiniteDifferenceGradient() {
+    // f(x) = sum_i i * x_i^2 with gradient 2 * i * x_i
+    auto f = [](const Vector& x) {
+        double sum = 0;
+        for (int i = 0; i < x.size(); i++) sum += i * x[i] * x[i];
+        return sum;
+    };
+    Vector x(4, 0.5), gradient;
+    double upper[4] = {1, 1, 1, 0.5};
+    for (auto method : {FiniteDifferenceGradient::Forward,
+                        FiniteDifferenceGradient::Central}) {
+        FiniteDifferenceGradient fd(f, method);
+        fd.setBounds(nullptr, upper);
+        fd.compute(x, gradient);
+        for (int i = 0; i < x.size(); i++) {
+            assertEqual(gradient[i], 2 * i * x[i], 1e-4, "gradient");
+        }
+    }
+    // A box narrower than the steps: the function is never evaluated
+    // outside of it.
+    double narrowLower[4] = {0.45, 0.45, 0.45, 0.45};
+    double narrowUpper[4] = {0.5, 0.5, 0.5, 0.5};
+    auto bounded = [&](const Vector& x) {
+        for (int i = 0; i < x.size(); i++) {
+            if (x[i] < narrowLower[i] || x[i] > narrowUpper[i]) {
+                throw Exception("evaluated outside the bounds");
+            }
+        }
+        return f(x);
+    };
+    for (auto method : {FiniteDifferenceGradient::Forward,
+                        FiniteDifferenceGradient::Central}) {
+        FiniteDifferenceGradient fd(bounded, method);
+        fd.setStepSizes(Vector(4, 0.1));
+        fd.setBounds(narrowLower, narrowUpper);
+        fd.compute(x, gradient);
+        for (int i = 0; i < x.size(); i++) {
+            assertEqual(gradient[i], 2 * i * x[i], 0.06 * i, "gradient");
+        }
+    }
+    cout << "FiniteDifferenceGradient: ok" << endl;
+}
+
+void testAsyncWriter() {
+    int last = -1;
+    {
+        AsyncWriter writer;
+        for (int i = 0; i < 100; i++) {
+            writer.submit("best", [&last, i]() { last = i; });
+        }
+        writer.flush();
+        if (last != 99) throw Exception("latest task was not written");
+        if (writer.getNumWritten() + writer.getNumCoalesced() != 100) {
+            throw Exception("tasks were lost");
+        }
+        writer.submit("best", [&last]() { last = 100; });
+    }
+    // pending tasks are written on destruction
+    if (last != 100) throw Exception("pending task was not written");
+    cout << "AsyncWriter: ok" << endl;
+}
+
+void testOptimizationCheckpoint() {
+    // samples with mean 1 and a deviation of 0.1 per coordinate
+    vector<Vector> samples = {Vector(3, 0.9), Vector(3, 1.1)};
+    OptimizationCheckpoint checkpoint;
+    checkpoint.numEvaluations = 42;
+    checkpoint.bestObjective = -0.5;
+    checkpoint.incumbent = Vector(3, 0.3);
+    OptimizationCheckpoint::estimateDistribution(samples, checkpoint.mean,
+                                                 checkpoint.stepSize);
+    assertEqual(checkpoint.mean[1], 1, 1e-12, "mean");
+    assertEqual(checkpoint.stepSize, sqrt(0.02), 1e-12, "step size");
+
+    checkpoint.save("test_checkpoint.txt");
+    OptimizationCheckpoint restored;
+    if (!restored.load("test_checkpoint.txt")) {
+        throw Exception("checkpoint not found");
+    }
+    if (restored.numEvaluations != 42 || restored.bestObjective != -0.5 ||
+        (restored.incumbent - checkpoint.incumbent).normInf() != 0 ||
+        (restored.mean - checkpoint.mean).normInf() != 0 ||
+        restored.stepSize != checkpoint.stepSize) {
+        throw Exception("checkpoint is not restored");
+    }
+    cout << "OptimizationCheckpoint: ok" << endl;
+}
+
+void testEnsembleRunner() {
+    // every third run fails, which must not abort the remaining runs
+    EnsembleRunner runner({"square"});
+    const auto& results = runner.run(10, [](int i) {
+        if (i % 3 == 0) throw Exception("run " + to_string(i));
+        return vector<double>{double(i * i)};
+    });
+    if (runner.getNumFailures() != 4) {
+        throw Exception("wrong number of failures");
+    }
+    for (int i = 0; i < 10; i++) {
+        if (results[i].succeeded == (i % 3 == 0)) {
+            throw Exception("wrong status of run " + to_string(i));
+        }
+        if (results[i].succeeded) {
+            assertEqual(results[i].values[0], i * i, 0, "value");
+        }
+    }
+    cout << "EnsembleRunner: ok" << endl;
+}
+
+void testBinaryStorage() {
+    Storage storage;
+    storage.setName("test");
+    Array<string> labels;
+    labels.append("time");
+    labels.append("a");
+    labels.append("b");
+    storage.setColumnLabels(labels);
+    for (int i = 0; i < 100; i++) {
+        double row[2] = {1.0 / (i + 3), exp(-i) * 1e-300};
+        storage.append(0.01 * i, 2, row);
+    }
+    BinaryStorage::write(storage, "test.osb", {"m", "N"});
+
+    // values must be restored exactly, with and without memory mapping
+    for (bool memoryMap : {true, false}) {
+        BinaryStorage binary("test.osb", memoryMap);
+        if (binary.getNumRows() != 100 || binary.getNumColumns() != 3 ||
+            binary.getColumnLabels()[2] != "b" || binary.getUnits()[1] != "m") {
+            throw Exception("wrong header");
+        }
+        for (int i = 0; i < 100; i++) {
+            const auto& row = storage.getStateVector(i)->getData();
+            assertEqual(binary.getColumn("time")[i],
+                        storage.getStateVector(i)->getTime(), 0, "time");
+            assertEqual(binary.getColumn(1)[i], row[0], 0, "a");
+            assertEqual(binary.getColumn(2)[i], row[1], 0, "b");
+        }
+    }
+
+    // the conversion to text must be lossless
+    BinaryStorage::convertToSto("test.osb", "test.sto");
+    BinaryStorage::convertFromSto("test.sto", "test_converted.osb");
+    BinaryStorage original("test.osb"), converted("test_converted.osb");
+    for (int j = 0; j < 3; j++) {
+        for (int i = 0; i < 100; i++) {
+            assertEqual(converted.getColumn(j)[i], original.getColumn(j)[i],
+                        0, "converted");
+        }
+    }
+    cout << "BinaryStorage: ok" << endl;
+}
+
+void testStreamingStateRecorder() {
+    // the trajectory is longer than the chunks, so that they are reused
+    double h0 = 1, tf = 0.4;
+    auto model = createFallingBody(h0);
+    auto recorder = new StreamingStateRecorder("streamed.sto", 5, 2);
+    model.addAnalysis(recorder);
+    auto binaryRecorder = new StreamingStateRecorder("streamed.osb", 5, 2);
+    model.addAnalysis(binaryRecorder);
+    auto state = model.initSystem();
+    Manager manager(model);
+    manager.setIntegratorMaximumStepSize(0.01);
+    manager.setWriteToStorage(false);
+    manager.initialize(state);
+    manager.integrate(tf);
+
+    Storage streamed("streamed.sto");
+    if (streamed.getSize() != recorder->getNumRows() ||
+        streamed.getSize() < 40) {
+        throw Exception("wrong number of rows");
+    }
+    assertEqual(streamed.getFirstTime(), 0, 0, "first time");
+    assertEqual(streamed.getLastTime(), tf, 1e-12, "last time");
+    assertEqual(streamed.getStateVector(0)->getData()[0], h0, 0, "h0");
+
+    // the binary file holds the same values (the text is lossless)
+    BinaryStorage binary("streamed.osb");
+    if (binary.getNumRows() != streamed.getSize() ||
+        binary.getNumColumns() != streamed.getColumnLabels().getSize()) {
+        throw Exception("wrong size of the binary file");
+    }
+    for (int i = 0; i < streamed.getSize(); i++) {
+        const auto& row = streamed.getStateVector(i)->getData();
+        assertEqual(binary.getColumn(0)[i],
+                    streamed.getStateVector(i)->getTime(), 0, "binary time");
+        for (int j = 0; j < row.getSize(); j++) {
+            assertEqual(binary.getColumn(j + 1)[i], row[j], 0,
+                        "binary value");
+        }
+    }
+    cout << "StreamingStateRecorder: ok" << endl;
+}
+
+void testFixedRateReporting() {
+    double h0 = 2, tf = 0.5, g = 9.81, interval = 0.01;
+    auto model = createFallingBody(h0);
+    auto state = model.initSystem();
+    RolloutContext context(model);
+    // only the height is recorded
+    context.setRecordedStates({model.getStateVariableNames()[0]});
+    for (auto mode : {RolloutContext::Stop, RolloutContext::Interpolate}) {
+        context.setReportInterval(interval, mode);
+        context.simulate(state, tf);
+        const auto& states = context.getStateStorage();
+        if (states.getSize() != 51 || states.getColumnLabels().getSize() != 2) {
+            throw Exception("wrong size of the state storage");
+        }
+        for (int i = 0; i < states.getSize(); i++) {
+            double t = states.getStateVector(i)->getTime();
+            assertEqual(t, i * interval, 1e-12, "report time");
+            assertEqual(states.getStateVector(i)->getData()[0],
+                        h0 - 0.5 * g * t * t, 1e-6, "height");
+        }
+    }
+    cout << "RolloutContext reporting: ok" << endl;
+}
+
+void testLatestValue() {
+    // the consumer must observe increasing values and the last one
+    LatestValue<int> slot;
+    const int n = 100000;
+    thread producer([&slot]() {
+        for (int i = 0; i < n; i++) {
+            slot.back() = i;
+            slot.publish();
+        }
+    });
+    int last = -1;
+    while (last != n - 1) {
+        if (!slot.update()) continue;
+        if (slot.front() < last) throw Exception("older value was acquired");
+        last = slot.front();
+    }
+    producer.join();
+    cout << "LatestValue: ok" << endl;
+}
+
+void testIntegratorTuner() {
+    auto model = createFallingBody(2.0, 1.0);
+    auto state = model.initSystem();
+    IntegratorTuner tuner(model, state, 0.5);
+    tuner.setMethods({Manager::IntegratorMethod::ExplicitEuler,
+                      Manager::IntegratorMethod::RungeKuttaMerson});
+    tuner.setAccuracies({1e-2, 1e-6});
+    tuner.setFixedStepSizes({1e-3});
+    double tolerance = 1e-6;
+    auto settings = tuner.tune(tolerance);
+    tuner.printReport(cout);
+    bool found = false;
+    for (const auto& trial : tuner.getTrials()) {
+        // explicit Euler has no error control and is tried with a fixed step
+        if (trial.settings.getMethod() ==
+                    Manager::IntegratorMethod::ExplicitEuler &&
+            trial.settings.get_fixed_step_size() != 1e-3) {
+            throw Exception("fixed step method without a step size");
+        }
+        if (trial.settings.get_integrator_method() ==
+                    settings.get_integrator_method() &&
+            trial.settings.get_accuracy() == settings.get_accuracy() &&
+            trial.settings.get_fixed_step_size() ==
+                    settings.get_fixed_step_size()) {
+            found = trial.error <= tolerance;
+        }
+    }
+    if (!found) throw Exception("selected settings exceed the tolerance");
+    if (tuner.getTrials().size() != 3) throw Exception("wrong candidates");
+
+    // the settings are restored from the file
+    settings.print("integrator_settings.xml");
+    IntegratorSettings loaded("integrator_settings.xml");
+    if (loaded.getMethod() != settings.getMethod() ||
+        loaded.get_accuracy() != settings.get_accuracy()) {
+        throw Exception("settings were not restored");
+    }
+    cout << "IntegratorTuner: ok" << endl;
+}
+
+void testModelSnapshot() {
+    string sourceFile = "test_falling_body.osim";
+    string snapshotFile = "test_falling_body.oss";
+    createFallingBody(1.0).print(sourceFile);
+    remove(snapshotFile.c_str());
+
+    // the model is parsed once and copied
+    auto model = ModelSnapshot::loadModel(sourceFile);
+    auto state = model.initSystem();
+    Vector values = model.getStateVariableValues(state);
+    for (int i = 0; i < values.size(); i++) values[i] = 0.1 * (i + 1);
+    model.setStateVariableValues(state, values);
+    ModelSnapshot::capture(model, state, sourceFile).save(snapshotFile);
+
+    // the state is restored into a new model of the same file
+    auto copy = ModelSnapshot::loadModel(sourceFile);
+    auto restored = copy.initSystem();
+    if (!ModelSnapshot::equilibrateMuscles(copy, restored, sourceFile,
+                                           snapshotFile)) {
+        throw Exception("snapshot was not restored");
+    }
+    Vector restoredValues = copy.getStateVariableValues(restored);
+    for (int i = 0; i < values.size(); i++) {
+        assertEqual(restoredValues[i], values[i], 0,
+                    "restored state variable");
+    }
+
+    // a modified source file invalidates the snapshot
+    createFallingBody(2.0).print(sourceFile);
+    ModelSnapshot snapshot;
+    snapshot.load(snapshotFile);
+    if (snapshot.isValidFor(copy, sourceFile)) {
+        throw Exception("snapshot of a modified file is valid");
+    }
+    cout << "ModelSnapshot: ok" << endl;
+}
+
+void testControlSwitchEvent() {
+    // a thrust that cancels the gravity in [0.2, 0.4)
+    double h0 = 1, g = 9.81;
+    auto model = createFallingBody(h0);
+    auto thrust = new CoordinateActuator("height");
+    thrust->setName("thrust");
+    thrust->setOptimalForce(1);
+    model.addForce(thrust);
+    auto controller = new PrescribedController();
+    controller->addActuator(*thrust);
+    double t[3] = {0.0, 0.2, 0.4}, x[3] = {0.0, g, 0.0};
+    controller->prescribeControlForActuator(
+            "thrust", new PiecewiseConstantFunction(3, t, x));
+    model.addController(controller);
+    model.buildSystem();
+    auto event = ControlSwitchEvent::addToModel(model);
+    if (!event || event->getTimes().size() != 3) {
+        throw Exception("switching times were not found");
+    }
+    auto state = model.initializeState();
+
+    // the integration stops exactly at the switches
+    RolloutContext context(model);
+    context.simulate(state, 0.5);
+    const auto& states = context.getStateStorage();
+    int numSwitches = 0;
+    for (int i = 0; i < states.getSize(); i++) {
+        double time = states.getStateVector(i)->getTime();
+        if (time == 0.2 || time == 0.4) numSwitches++;
+    }
+    if (numSwitches != 2) throw Exception("switches were not reached");
+    double h = h0 - 0.5 * g * 0.2 * 0.2 - g * 0.2 * 0.2 - g * 0.2 * 0.1 -
+               0.5 * g * 0.1 * 0.1;
+    assertEqual(model.getCoordinateSet().get("height").getValue(
+                        context.getIntegrator().getState()),
+                h, 1e-4, "height");
+    cout << "ControlSwitchEvent: ok" << endl;
+}
+
+void testPrefixStateCache() {
+    // a thrust that is piecewise constant over four intervals, the
+    // integration is restarted at the knots and the states are cached as in
+    // HopperRollout
+    double g = 9.81, tf = 0.4;
+    auto model = createFallingBody(1.0);
+    auto thrust = new CoordinateActuator("height");
+    thrust->setName("thrust");
+    thrust->setOptimalForce(1);
+    model.addForce(thrust);
+    auto controller = new PrescribedController();
+    controller->addActuator(*thrust);
+    vector<double> t = {0.0, 0.1, 0.2, 0.3}, x(4, 0.0);
+    auto function = new PiecewiseConstantFunction(4, &t[0], &x[0]);
+    controller->prescribeControlForActuator("thrust", function);
+    model.addController(controller);
+    auto state = model.initSystem();
+    int N = (int) t.size();
+    auto setControls = [&](const Vector& controls) {
+        for (int i = 0; i < N; i++) function->setY(i, controls[i]);
+    };
+
+    PrefixStateCache cache(10);
+    Vector controls;
+    RolloutContext context(model);
+    context.setRestartTimes(vector<double>(t.begin() + 1, t.end()));
+    context.setRestartCallback([&](const State& s, int i) {
+        if (i + 2 >= N) return;
+        PrefixStateCache::Snapshot snapshot;
+        snapshot.time = s.getTime();
+        snapshot.y = s.getY();
+        cache.insert(controls, i + 2, snapshot);
+    });
+
+    // the candidate differs from the cached simulation only in the control
+    // that starts at the second knot
+    double first[4] = {0, 2 * g, 0, g}, second[4] = {0, 2 * g, 3 * g, g};
+    controls = Vector(4, first);
+    setControls(controls);
+    context.simulate(state, tf);
+    controls = Vector(4, second);
+    setControls(controls);
+    PrefixStateCache::Snapshot snapshot;
+    int prefix = cache.lookup(controls, N - 1, snapshot);
+    if (prefix != 2) throw Exception("wrong prefix was resumed");
+    Vector complete = context.simulate(state, tf).getY();
+
+    State resumeState = state;
+    resumeState.setTime(snapshot.time);
+    resumeState.updY() = snapshot.y;
+    Vector resumed = context.simulate(resumeState, tf, false).getY();
+    for (int i = 0; i < complete.size(); i++) {
+        assertEqual(resumed[i], complete[i], 1e-12, "resumed state");
+    }
+    cout << "PrefixStateCache: ok" << endl;
+}
+
+void testControlBasisFunction() {
+    // a uniform cubic B-spline reproduces the linear function of linear
+    // coefficients, 1 + 4 t for four segments over [0, 1]
+    Vector linear(7);
+    for (int i = 0; i < linear.size(); i++) linear[i] = i;
+    ControlBasisFunction spline("bspline", 3, 0, 1, linear);
+    for (double t : {0.0, 0.3, 0.55, 1.0}) {
+        assertEqual(spline.calcValue(Vector(1, t)), 1 + 4 * t, 1e-12,
+                    "B-spline value");
+        assertEqual(spline.calcDerivative({0}, Vector(1, t)), 4, 1e-12,
+                    "B-spline derivative");
+    }
+    assertEqual(spline.calcValue(Vector(1, 2.0)), 5, 1e-12,
+                "B-spline value after the end");
+
+    // a piecewise Bezier curve interpolates the ends of its segments
+    double points[7] = {0, 1, 0, 2, 3, 1, 1};
+    ControlBasisFunction bezier("bezier", 3, 0, 1, Vector(7, points));
+    assertEqual(bezier.calcValue(Vector(1, 0.0)), 0, 1e-12, "Bezier start");
+    assertEqual(bezier.calcValue(Vector(1, 0.5)), 2, 1e-12, "Bezier joint");
+    assertEqual(bezier.calcValue(Vector(1, 1.0)), 1, 1e-12, "Bezier end");
+    double h = 1e-6, t = 0.3;
+    assertEqual(bezier.calcDerivative({0}, Vector(1, t)),
+                (bezier.calcValue(Vector(1, t + h)) -
+                 bezier.calcValue(Vector(1, t - h))) /
+                        (2 * h),
+                1e-6, "Bezier derivative");
+
+    // the function is restored from a file
+    bezier.print("test_control_basis.xml");
+    unique_ptr<Object> object(
+            Object::makeObjectFromFile("test_control_basis.xml"));
+    auto loaded = dynamic_cast<ControlBasisFunction*>(object.get());
+    if (!loaded) throw Exception("function was not restored");
+    assertEqual(loaded->calcValue(Vector(1, t)),
+                bezier.calcValue(Vector(1, t)), 1e-12, "restored value");
+
+    // the number of coefficients must match the basis
+    bool thrown = false;
+    try {
+        ControlBasisFunction("bezier", 3, 0, 1, Vector(6, 0.0));
+    } catch (const Exception&) {
+        thrown = true;
+    }
+    if (!thrown) throw Exception("invalid coefficients were accepted");
+    cout << "ControlBasisFunction: ok" << endl;
+}
+
+void testMonteCarloCampaign() {
+    // run i samples the values i and 2 i at two times, every tenth run
+    // fails; the statistics are accumulated over two batches
+    MonteCarloCampaign campaign({0.0, 1.0}, {"x"}, {0.5});
+    auto rollout = [](int i, vector<double>& samples) {
+        if (i % 10 == 9) throw Exception("failed run");
+        samples[0] = i;
+        samples[1] = 2 * i;
+    };
+    campaign.run(50, rollout);
+    campaign.run(50, rollout);
+    if (campaign.getNumRuns() != 90 || campaign.getNumFailures() != 10) {
+        throw Exception("runs were not counted");
+    }
+    // the mean of i over the successful runs
+    double sum = 0, sumSquares = 0;
+    for (int i = 0; i < 100; i++) {
+        if (i % 10 == 9) continue;
+        sum += i;
+        sumSquares += i * i;
+    }
+    double mean = sum / 90, variance = (sumSquares - 90 * mean * mean) / 89;
+    assertEqual(campaign.getMoments(0, 0).getMean(), mean, 1e-9, "mean");
+    assertEqual(campaign.getMoments(0, 0).getVariance(), variance, 1e-9,
+                "variance");
+    assertEqual(campaign.getMoments(1, 0).getMean(), 2 * mean, 1e-9,
+                "mean at the second time");
+    // the streaming median of a uniform sequence
+    assertEqual(campaign.getQuantile(0, 0, 0), 49.5, 3, "median");
+
+    // the P^2 estimate is exact for up to five values
+    P2Quantile quantile(0.25);
+    for (double value : {5.0, 1.0, 3.0}) quantile.add(value);
+    assertEqual(quantile.getValue(), 2.0, 1e-12, "exact quantile");
+    cout << "MonteCarloCampaign: ok" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testOutputReducer();
+        testApexTermination();
+        testBallisticBoundWithTwoHops();
+        testEvaluationCache();
+        testFiniteDifferenceGradient();
+        testAsyncWriter();
+        testOptimizationCheckpoint();
+        testEnsembleRunner();
+        testBinaryStorage();
+        testStreamingStateRecorder();
+        testFixedRateReporting();
+        testLatestValue();
+        testIntegratorTuner();
+        testModelSnapshot();
+        testControlSwitchEvent();
+        testPrefixStateCache();
+        testControlBasisFunction();
+        testMonteCarloCampaign();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        PAUSE;
+        return -1;
+    }
+    PAUSE;
+    return 0;
+}